@@ -0,0 +1,110 @@
+#include "./arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_MIN_BLOCK_SIZE (64 * 1024)
+#define ARENA_MAX_BLOCK_SIZE (4 * 1024 * 1024)
+
+// Everything we hand out is aligned as malloc would do
+#define ALIGNMENT sizeof(max_align_t)
+#define align(size) (((size) + ALIGNMENT - 1) & ~(ALIGNMENT - 1))
+
+static Arena_Block *new_block(size_t size) {
+    Arena_Block *block = malloc(sizeof(Arena_Block) + size);
+
+    if (block == NULL) {
+        fprintf(stderr, "could not allocate memory enough for the arena\n");
+        exit(1);
+    }
+
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+
+    return block;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    size = align(size);
+
+    if (arena->head == NULL || arena->head->used + size > arena->head->size) {
+        // every new block is twice as big as the previous one, so big files need only a few of them
+        size_t block_size = arena->head == NULL ? ARENA_MIN_BLOCK_SIZE : arena->head->size * 2;
+
+        if (block_size > ARENA_MAX_BLOCK_SIZE) block_size = ARENA_MAX_BLOCK_SIZE;
+        if (block_size < size) block_size = size;
+
+        Arena_Block *block = new_block(block_size);
+
+        block->next = arena->head;
+        arena->head = block;
+    }
+
+    void *ptr = (char*)arena->head->data + arena->head->used;
+
+    arena->head->used += size;
+
+    return ptr;
+}
+
+void *arena_realloc(Arena *arena, void *ptr, size_t old_size, size_t new_size) {
+    if (ptr == NULL) return arena_alloc(arena, new_size);
+
+    if (new_size <= old_size) return ptr;
+
+    Arena_Block *head = arena->head;
+    char *end = (char*)head->data + head->used;
+
+    if ((char*)ptr + align(old_size) == end && head->used - align(old_size) + align(new_size) <= head->size) {
+        head->used += align(new_size) - align(old_size);
+
+        return ptr;
+    }
+
+    void *output = arena_alloc(arena, new_size);
+
+    memcpy(output, ptr, old_size);
+
+    return output;
+}
+
+char *arena_strndup(Arena *arena, const char *string, size_t size) {
+    char *output = arena_alloc(arena, size + 1);
+
+    memcpy(output, string, size);
+    output[size] = '\0';
+
+    return output;
+}
+
+size_t arena_used(const Arena *arena) {
+    size_t used = 0;
+
+    for (Arena_Block *block = arena->head; block != NULL; block = block->next) used += block->used;
+
+    return used;
+}
+
+size_t arena_reserved(const Arena *arena) {
+    size_t reserved = 0;
+
+    for (Arena_Block *block = arena->head; block != NULL; block = block->next) reserved += sizeof(Arena_Block) + block->size;
+
+    return reserved;
+}
+
+void arena_free(Arena *arena) {
+    Arena_Block *block = arena->head;
+
+    while (block != NULL) {
+        Arena_Block *next = block->next;
+
+        free(block);
+
+        block = next;
+    }
+
+    arena->head = NULL;
+}
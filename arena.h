@@ -0,0 +1,31 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stddef.h>
+
+// A bump allocator. Everything allocated from an arena is released at once by `arena_free`, so
+// the things living inside of it (like the AST of a file) never need to be freed one by one.
+
+typedef struct Arena_Block Arena_Block;
+
+struct Arena_Block {
+    Arena_Block *next;
+    size_t size, used;
+    max_align_t data[];
+};
+
+typedef struct {
+    Arena_Block *head;
+} Arena;
+
+void *arena_alloc(Arena *arena, size_t size);
+// If `ptr` is the last thing allocated and there is room after it, it grows in place.
+// Otherwise a new space is allocated and the old one is just left behind until the arena is freed.
+void *arena_realloc(Arena *arena, void *ptr, size_t old_size, size_t new_size);
+char *arena_strndup(Arena *arena, const char *string, size_t size);
+// How many bytes were handed out, and how many were reserved from the system
+size_t arena_used(const Arena *arena);
+size_t arena_reserved(const Arena *arena);
+void arena_free(Arena *arena);
+
+#endif // !ARENA_H_
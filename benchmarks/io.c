@@ -0,0 +1,105 @@
+// Loading and lexing a file: read into a malloc'd buffer, like `read_from_file` used to, against the
+// mapped content it returns now. The file is written once and then read from the page cache.
+//
+// usage: ./bench_io [megabytes] [path of the file to write]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../io.h"
+#include "../lexer.h"
+
+#define ROUNDS 5
+
+static const char *chunk =
+    "base_url = \"http://localhost:3030/some/very/long/path/that/we/want/to/serve/from/here\"\n"
+    "route_names = { home = \"Home\", dashboard = \"Dashboard\" }\n"
+    "numbers = [1 2 3 4 5 6 7 8 9 10 11.5 12.25]\n";
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char *old_read_from_file(const char *filename, size_t *size) {
+    FILE *fptr = fopen(filename, "r");
+
+    fseek(fptr, 0, SEEK_END);
+    *size = ftell(fptr);
+    rewind(fptr);
+
+    char *content = malloc(*size + 1);
+
+    if (fread(content, 1, *size, fptr) != *size) {
+        fprintf(stderr, "could not read %s\n", filename);
+        exit(1);
+    }
+
+    content[*size] = '\0';
+
+    fclose(fptr);
+
+    return content;
+}
+
+// How long it takes to get the content in memory, and then to lex it too
+static void load_and_lex(const char *filename, bool mapped, double *load, double *total) {
+    double start = now();
+    File_Content content = {0};
+
+    if (mapped) {
+        content = read_from_file(filename);
+    } else {
+        content.data = old_read_from_file(filename, &content.size);
+    }
+
+    *load = now() - start;
+
+    Lexer lexer = create_lexer(filename, content.data, content.size);
+
+    if (lex(&lexer) == NULL) {
+        fprintf(stderr, "lexing failed\n");
+        exit(1);
+    }
+
+    lexer_free(&lexer);
+    file_content_free(&content);
+
+    *total = now() - start;
+}
+
+int main(int argc, char **argv) {
+    size_t megabytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 200;
+    const char *filename = argc > 2 ? argv[2] : "bench_io.es";
+
+    FILE *file = fopen(filename, "w");
+    size_t chunk_size = strlen(chunk);
+
+    for (size_t written = 0; written < megabytes * 1024 * 1024; written += chunk_size) fputs(chunk, file);
+
+    fclose(file);
+
+    const char *names[] = {"read", "mmap"};
+
+    for (int mapped = 0; mapped <= 1; ++mapped) {
+        double best_load = 0, best_total = 0;
+
+        for (int round = 0; round < ROUNDS; ++round) {
+            double load, total;
+
+            load_and_lex(filename, mapped, &load, &total);
+
+            if (best_load == 0 || load < best_load) best_load = load;
+            if (best_total == 0 || total < best_total) best_total = total;
+        }
+
+        printf("%-5s load %8.1f ms, load + lex %8.1f ms  (%zu MB, best of %d)\n", names[mapped], best_load * 1e3, best_total * 1e3, megabytes, ROUNDS);
+    }
+
+    remove(filename);
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Lexing throughput (MB/s) of every scanning implementation available on this cpu.
+// The "scalar" one moves byte by byte, exactly like the lexer used to, so it's the baseline to compare with.
+//
+// usage: ./bench_lexer [megabytes]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../lexer.h"
+#include "../simd.h"
+
+#define ROUNDS 5
+
+static const char *chunk =
+    "# this is the base url for the app, and this comment is long enough to be worth skipping at once\n"
+    "base_url = \"http://localhost:3030/some/very/long/path/that/we/want/to/serve/from/here\"\n"
+    "app_name = \"testing some stuff\"        # this is the name of my app\n"
+    "route_names = {\n"
+    "        home = \"Home\"\n"
+    "        dashboard = \"Dashboard with an \\\"escaped\\\" word\"\n"
+    "}\n"
+    "numbers = [1 2 3 4 5 6 7 8 9 10]\n"
+    "\n";
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char *generate(size_t size) {
+    size_t chunk_size = strlen(chunk);
+    char *data = malloc(size + 1);
+
+    for (size_t i = 0; i < size; i += chunk_size) {
+        memcpy(data + i, chunk, i + chunk_size <= size ? chunk_size : size - i);
+    }
+
+    // do not cut a line in the middle
+    size_t end = size;
+    while (end > 0 && data[end - 1] != '\n') --end;
+    data[end] = '\0';
+
+    return data;
+}
+
+static void bench(const char *name, char *data, size_t size) {
+    if (!simd_use_implementation(name)) {
+        printf("%-8s not available on this cpu\n", name);
+        return;
+    }
+
+    double best = 0;
+    size_t tokens = 0;
+
+    for (int round = 0; round < ROUNDS; ++round) {
+        Lexer lexer = create_lexer("<bench>", data, size);
+
+        double start = now();
+
+        if (lex(&lexer) == NULL) {
+            fprintf(stderr, "lexing failed\n");
+            exit(1);
+        }
+
+        double elapsed = now() - start;
+
+        tokens = lexer.tokens.length;
+
+        lexer_free(&lexer);
+
+        if (best == 0 || elapsed < best) best = elapsed;
+    }
+
+    printf("%-8s %8.1f MB/s  (%zu tokens, best of %d)\n", name, size / best / (1024.0 * 1024.0), tokens, ROUNDS);
+}
+
+int main(int argc, char **argv) {
+    size_t megabytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 64;
+    char *data = generate(megabytes * 1024 * 1024);
+    size_t size = strlen(data);
+
+    printf("lexing %zu bytes\n", size);
+
+    bench("scalar", data, size);
+    bench("sse2", data, size);
+    bench("avx2", data, size);
+
+    free(data);
+
+    return 0;
+}
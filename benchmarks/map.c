@@ -0,0 +1,204 @@
+// Insert and lookup cost (ns per key) of the symbols map, compared with the fixed 512-bucket chained
+// table it replaced (copied here as `old_*`, with its hash, one allocation per node and a copy of the value).
+//
+// usage: ./bench_map [max keys]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../map.h"
+
+#define OLD_BUCKET_SIZE 512
+
+typedef struct Old_Node {
+    const char *key;
+    size_t key_size;
+    void *data;
+    struct Old_Node *next;
+} Old_Node;
+
+typedef struct {
+    Old_Node *nodes[OLD_BUCKET_SIZE];
+} Old_Map;
+
+// what a Symbol takes in the interpreter
+typedef struct {
+    char bytes[72];
+} Value;
+
+static size_t old_hash(const char *key, size_t key_size) {
+    unsigned long hash = 5381;
+
+    for (size_t i = 0; i < key_size; ++i) {
+        hash = ((hash << 5) + hash) + (int)(key[i] - '0');
+    }
+
+    return hash % OLD_BUCKET_SIZE;
+}
+
+static void old_set(Old_Map *map, const char *key, size_t key_size, void *data, size_t data_size) {
+    Old_Node **current = &map->nodes[old_hash(key, key_size)];
+
+    while (*current != NULL) {
+        if ((*current)->key_size == key_size && memcmp((*current)->key, key, key_size) == 0) {
+            memcpy((*current)->data, data, data_size);
+            return;
+        }
+
+        current = &(*current)->next;
+    }
+
+    Old_Node *node = calloc(1, sizeof(Old_Node));
+
+    node->key = key;
+    node->key_size = key_size;
+    node->data = malloc(data_size);
+    memcpy(node->data, data, data_size);
+
+    *current = node;
+}
+
+static void *old_get(Old_Map *map, const char *key, size_t key_size) {
+    for (Old_Node *node = map->nodes[old_hash(key, key_size)]; node != NULL; node = node->next) {
+        if (node->key_size == key_size && memcmp(node->key, key, key_size) == 0) return node->data;
+    }
+
+    return NULL;
+}
+
+static void old_free(Old_Map *map) {
+    for (size_t i = 0; i < OLD_BUCKET_SIZE; ++i) {
+        Old_Node *node = map->nodes[i];
+
+        while (node != NULL) {
+            Old_Node *next = node->next;
+            free(node->data);
+            free(node);
+            node = next;
+        }
+    }
+
+    free(map);
+}
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct {
+    char *buffer;
+    size_t *offsets;
+    size_t *sizes;
+} Keys;
+
+// names like the ones in a real file: same prefix, only the end changes
+static Keys make_keys(size_t count) {
+    Keys keys = {
+        .buffer = malloc(count * 32),
+        .offsets = malloc(count * sizeof(size_t)),
+        .sizes = malloc(count * sizeof(size_t)),
+    };
+
+    size_t offset = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        int size = sprintf(keys.buffer + offset, "route_name_%zu", i);
+
+        keys.offsets[i] = offset;
+        keys.sizes[i] = size;
+        offset += size;
+    }
+
+    return keys;
+}
+
+static void bench(size_t count, size_t max_old) {
+    Keys keys = make_keys(count);
+    Value value = {0};
+    // small maps are too quick to time just once
+    size_t rounds = count <= 1000 ? 100 : 3;
+    double best_insert = 1e9, best_lookup = 1e9;
+
+    for (size_t round = 0; round < rounds; ++round) {
+        double start = now();
+        Map *map = map_new(sizeof(Value));
+        for (size_t i = 0; i < count; ++i) {
+            value.bytes[0] = (char)i;
+            map_set(map, keys.buffer + keys.offsets[i], keys.sizes[i], &value);
+        }
+        double insert = now() - start;
+
+        size_t found = 0;
+        start = now();
+        for (size_t i = 0; i < count; ++i) {
+            found += map_get(map, keys.buffer + keys.offsets[i], keys.sizes[i]) != NULL;
+        }
+        double lookup = now() - start;
+        map_free(map);
+
+        if (found != count) {
+            fprintf(stderr, "Error: lost keys\n");
+            exit(EXIT_FAILURE);
+        }
+
+        if (insert < best_insert) best_insert = insert;
+        if (lookup < best_lookup) best_lookup = lookup;
+    }
+
+    printf("%8zu keys  map      insert %8.1f ns/key  lookup %8.1f ns/key\n", count, best_insert / count * 1e9, best_lookup / count * 1e9);
+
+    if (count > max_old) {
+        printf("%8zu keys  old map  skipped (quadratic)\n", count);
+    } else {
+        best_insert = best_lookup = 1e9;
+
+        for (size_t round = 0; round < rounds; ++round) {
+            double start = now();
+            Old_Map *old = calloc(1, sizeof(Old_Map));
+            for (size_t i = 0; i < count; ++i) {
+                value.bytes[0] = (char)i;
+                old_set(old, keys.buffer + keys.offsets[i], keys.sizes[i], &value, sizeof(Value));
+            }
+            double insert = now() - start;
+
+            size_t found = 0;
+            start = now();
+            for (size_t i = 0; i < count; ++i) {
+                found += old_get(old, keys.buffer + keys.offsets[i], keys.sizes[i]) != NULL;
+            }
+            double lookup = now() - start;
+            old_free(old);
+
+            if (found != count) {
+                fprintf(stderr, "Error: lost keys\n");
+                exit(EXIT_FAILURE);
+            }
+
+            if (insert < best_insert) best_insert = insert;
+            if (lookup < best_lookup) best_lookup = lookup;
+        }
+
+        printf("%8zu keys  old map  insert %8.1f ns/key  lookup %8.1f ns/key\n", count, best_insert / count * 1e9, best_lookup / count * 1e9);
+    }
+
+    free(keys.buffer);
+    free(keys.offsets);
+    free(keys.sizes);
+}
+
+int main(int argc, char **argv) {
+    size_t max_keys = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    // the old table is a linked list per bucket, past this it takes minutes
+    size_t max_old = 100000;
+    size_t counts[] = {1000, 100000, 1000000};
+
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]) && counts[i] <= max_keys; ++i) {
+        bench(counts[i], max_old);
+    }
+
+    return 0;
+}
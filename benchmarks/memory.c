@@ -0,0 +1,134 @@
+// How much memory the AST of a document full of small arrays takes, compared with what it used to
+// take when every array grew straight to 100 items on the first append.
+//
+// usage: ./bench_memory [number of vars]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../lexer.h"
+#include "../parser.h"
+
+#define OLD_ARRAY_CAPACITY 100
+
+typedef struct {
+    size_t containers;
+    size_t items;
+    // what the arrays, objects, paths, arguments and indexes would take with the old growth policy
+    size_t old_bytes;
+} Stats;
+
+static size_t old_capacity(size_t length) {
+    if (length == 0) return 0;
+
+    size_t capacity = OLD_ARRAY_CAPACITY;
+
+    while (capacity < length) capacity *= 2;
+
+    return capacity;
+}
+
+static void count(Stats *stats, size_t length, size_t item_size) {
+    if (length == 0) return;
+
+    stats->containers += 1;
+    stats->items += length;
+    stats->old_bytes += old_capacity(length) * item_size;
+}
+
+static void walk_argument(Stats *stats, Argument argument);
+static void walk_var(Stats *stats, Var var);
+
+static void walk_metadata(Stats *stats, Metadata metadata) {
+    count(stats, metadata.indexes.length, sizeof(Argument));
+
+    for (size_t i = 0; i < metadata.indexes.length; ++i) walk_argument(stats, metadata.indexes.data[i]);
+}
+
+static void walk_fun_call(Stats *stats, Fun_Call *fun_call) {
+    count(stats, fun_call->arguments.length, sizeof(Argument));
+
+    for (size_t i = 0; i < fun_call->arguments.length; ++i) walk_argument(stats, fun_call->arguments.data[i]);
+}
+
+static void walk_argument(Stats *stats, Argument argument) {
+    walk_metadata(stats, argument.metadata);
+
+    switch (argument.kind) {
+        case AK_ARRAY: {
+            count(stats, argument.as.array.length, sizeof(Argument));
+
+            for (size_t i = 0; i < argument.as.array.length; ++i) walk_argument(stats, array_at(argument.as.array, i));
+        } break;
+        case AK_OBJECT: {
+            count(stats, argument.as.object.length, sizeof(Var));
+
+            for (size_t i = 0; i < argument.as.object.length; ++i) walk_var(stats, argument.as.object.data[i]);
+        } break;
+        case AK_PATH: count(stats, argument.as.path.length, sizeof(String)); break;
+        case AK_FUN_CALL: walk_fun_call(stats, argument.as.fun_call); break;
+        default: break;
+    }
+}
+
+static void walk_var(Stats *stats, Var var) {
+    walk_metadata(stats, var.metadata);
+
+    switch (var.kind) {
+        case VK_ARRAY: {
+            count(stats, var.as.array.length, sizeof(Argument));
+
+            for (size_t i = 0; i < var.as.array.length; ++i) walk_argument(stats, array_at(var.as.array, i));
+        } break;
+        case VK_OBJECT: {
+            count(stats, var.as.object.length, sizeof(Var));
+
+            for (size_t i = 0; i < var.as.object.length; ++i) walk_var(stats, var.as.object.data[i]);
+        } break;
+        case VK_PATH: count(stats, var.as.path.length, sizeof(String)); break;
+        case VK_FUN_CALL: walk_fun_call(stats, var.as.fun_call); break;
+        default: break;
+    }
+}
+
+static char *generate(size_t vars, size_t *size) {
+    size_t capacity = vars * 96 + 1;
+    char *data = malloc(capacity);
+
+    *size = 0;
+
+    for (size_t i = 0; i < vars; ++i) {
+        *size += snprintf(data + *size, capacity - *size, "v%c%c%c = [[%zu] $/v%c%c%c[0] sum_i(%zu)]\n", 'a' + (int)(i % 26), 'a' + (int)(i / 26 % 26), 'a' + (int)(i / 676 % 26), i, 'a' + (int)(i % 26), 'a' + (int)(i / 26 % 26), 'a' + (int)(i / 676 % 26), i);
+    }
+
+    return data;
+}
+
+static double mb(size_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+int main(int argc, char **argv) {
+    size_t vars = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    size_t size;
+    char *data = generate(vars, &size);
+
+    Lexer lexer = create_lexer("<bench>", data, size);
+    Parser parser = parse_tokens(lex(&lexer));
+
+    Stats stats = {0};
+
+    count(&stats, parser.length, sizeof(Var));
+
+    for (size_t i = 0; i < parser.length; ++i) walk_var(&stats, parser.vars[i]);
+
+    printf("%zu vars, %zu arrays/objects/paths/argument lists/indexes with %zu items in total\n", parser.length, stats.containers, stats.items);
+    printf("sizeof(Argument) = %zu, sizeof(Var) = %zu\n", sizeof(Argument), sizeof(Var));
+    printf("growing to %d on the first append: %10.2f MB\n", OLD_ARRAY_CAPACITY, mb(stats.old_bytes));
+    printf("right-sized (whole arena, strings included): %10.2f MB used, %.2f MB reserved\n", mb(arena_used(&parser.arena)), mb(arena_reserved(&parser.arena)));
+
+    parser_free(parser);
+    lexer_free(&lexer);
+    free(data);
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Indexing a 10k keys object by key 1M times, with the key index and with the plain scan it replaced.
+// The scan is way too slow for 1M lookups, so it only does 1% of them (the time per lookup is what matters).
+//
+// usage: ./bench_object [keys] [lookups]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../object.h"
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double run(Object object, const char *names, size_t lookups, size_t *checksum) {
+    size_t keys = object.length;
+    double start = now();
+
+    for (size_t i = 0; i < lookups; ++i) {
+        // spread the lookups all over the object
+        size_t k = (i * 7919) % keys;
+        const char *name = names + k * 24;
+
+        Var *var = object_get(object, name, strlen(name));
+
+        if (var == NULL) {
+            fprintf(stderr, "Error: key %s not found\n", name);
+            exit(EXIT_FAILURE);
+        }
+
+        *checksum += var->as.integer.value;
+    }
+
+    return now() - start;
+}
+
+int main(int argc, char **argv) {
+    size_t keys = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+    size_t scan_lookups = lookups / 100 > 0 ? lookups / 100 : 1;
+
+    char *names = calloc(keys, 24);
+    Object object = {
+        .length = keys,
+        .capacity = keys,
+        .data = calloc(keys, sizeof(Var)),
+    };
+
+    for (size_t i = 0; i < keys; ++i) {
+        char *name = names + i * 24;
+
+        snprintf(name, 24, "key_%zu", i);
+
+        object.data[i] = (Var){
+            .kind = VK_INTEGER,
+            .name = {.value = name, .size = strlen(name)},
+            .as.integer.value = (long)i,
+        };
+    }
+
+    size_t checksum = 0;
+
+    double scan = run(object, names, scan_lookups, &checksum);
+
+    Object_Index index = {0};
+    object.index = &index;
+
+    // the first lookup builds the index, so it's part of the time
+    double indexed = run(object, names, lookups, &checksum);
+
+    printf("%zu keys, %zu lookups (checksum %zu)\n", keys, lookups, checksum);
+    printf("  scan:  %10.1f ns/lookup  (~%.2fs for all of them)\n", scan / scan_lookups * 1e9, scan / scan_lookups * lookups);
+    printf("  index: %10.1f ns/lookup  (%.3fs)\n", indexed / lookups * 1e9, indexed);
+
+    object_index_free(&index);
+    free(object.data);
+    free(names);
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Summing a 1M items array of floats (and one of integers): packed in a plain buffer with every
+// vectorized implementation, and as an array of arguments, like every array used to be.
+//
+// usage: ./bench_sum [items]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../parser.h"
+#include "../simd.h"
+
+#define ROUNDS 20
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// what sum_af does with an array of arguments
+static double sum_arguments(const Argument *items, size_t length) {
+    double sum = 0;
+
+    for (size_t i = 0; i < length; ++i) {
+        switch (items[i].kind) {
+            case AK_FLOAT: sum += items[i].as.floating.value; break;
+            case AK_INTEGER: sum += items[i].as.integer.value; break;
+            default: abort();
+        }
+    }
+
+    return sum;
+}
+
+int main(int argc, char **argv) {
+    size_t length = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    double *floats = malloc(length * sizeof(double));
+    long *integers = malloc(length * sizeof(long));
+    Argument *arguments = calloc(length, sizeof(Argument));
+
+    for (size_t i = 0; i < length; ++i) {
+        floats[i] = (double)(i % 1000) / 7.0;
+        integers[i] = (long)(i % 1000) - 500;
+        arguments[i] = (Argument){.kind = AK_FLOAT, .as.floating.value = floats[i]};
+    }
+
+    printf("%zu items (%zu bytes as arguments, %zu packed)\n", length, length * sizeof(Argument), length * sizeof(double));
+
+    double best = 1e9, result = 0;
+
+    for (int round = 0; round < ROUNDS; ++round) {
+        double start = now();
+        result = sum_arguments(arguments, length);
+        double elapsed = now() - start;
+
+        if (elapsed < best) best = elapsed;
+    }
+
+    printf("  %-10s floats %8.3f ms  (%f)\n", "arguments", best * 1e3, result);
+
+    const char *names[] = {"scalar", "sse2", "avx2"};
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        if (!simd_use_implementation(names[i])) continue;
+
+        double best_floats = 1e9, best_integers = 1e9;
+        long integers_result = 0;
+
+        for (int round = 0; round < ROUNDS; ++round) {
+            double start = now();
+            result = simd_sum_floats(floats, length);
+            double elapsed = now() - start;
+
+            if (elapsed < best_floats) best_floats = elapsed;
+
+            start = now();
+            integers_result = simd_sum_integers(integers, length);
+            elapsed = now() - start;
+
+            if (elapsed < best_integers) best_integers = elapsed;
+        }
+
+        printf("  %-10s floats %8.3f ms  (%f)  integers %8.3f ms  (%ld)\n", names[i], best_floats * 1e3, result, best_integers * 1e3, integers_result);
+    }
+
+    free(floats);
+    free(integers);
+    free(arguments);
+
+    return 0;
+}
@@ -0,0 +1,492 @@
+#include "./cache.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "./import.h"
+#include "./utils.h"
+
+// The executable that is running, its hash is part of the key (see `build_hash`)
+#define EVALSET_EXECUTABLE "/proc/self/exe"
+// Bumped with every change to the layout below (a change to the evaluation needs nothing, see `build_hash`)
+#define CACHE_FORMAT 1
+#define CACHE_MAGIC "ESC\n"
+
+// Layout (the numbers are 64 bits, in the byte order of the machine):
+//   magic, format, key, number of imports, each import (path, hash), number of vars, each var (name, value)
+// A string (paths and names too) is its size and then its bytes. A value is a tag and then:
+//   'i' the integer, 'f' the float, 'b' 0 or 1, 'n' nothing, 's' the string,
+//   'a' the number of items and each value, 'o' the number of keys and each one (name, value)
+
+// Not cryptographic, it only has to tell a changed file apart. 8 bytes at a time, the files can be big.
+static uint64_t hash_bytes(uint64_t hash, const char *data, size_t size) {
+    size_t i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+
+        memcpy(&word, data + i, 8);
+
+        hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+        hash ^= hash >> 29;
+    }
+
+    for (; i < size; ++i) {
+        hash = (hash ^ (unsigned char)data[i]) * 1099511628211ULL;
+    }
+
+    hash ^= hash >> 32;
+    hash *= 0xd6e8feb86659fd93ULL;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+// The same hash as `hash_bytes` for the whole file, false if it can't be read
+static bool hash_file(const char *path, uint64_t *hash) {
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+
+    if (fd < 0) return false;
+
+    if (fstat(fd, &info) < 0 || !S_ISREG(info.st_mode)) {
+        close(fd);
+        return false;
+    }
+
+    if (info.st_size == 0) {
+        close(fd);
+        *hash = hash_bytes(0, NULL, 0);
+        return true;
+    }
+
+    char *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (data == MAP_FAILED) return false;
+
+    *hash = hash_bytes(0, data, info.st_size);
+
+    munmap(data, info.st_size);
+
+    return true;
+}
+
+// The caches made by another build are never used, it may evaluate things differently. Every build is a
+// different executable, so there is no version to remember to bump. False when it can't be read, then there
+// is no cache at all.
+static bool build_hash(uint64_t *hash) {
+    static bool known = false, found = false;
+    static uint64_t build = 0;
+
+    if (!known) {
+        found = hash_file(EVALSET_EXECUTABLE, &build);
+        known = true;
+    }
+
+    *hash = build;
+
+    return found;
+}
+
+// Where the cache of the file goes, NULL if the file can't be found (or the build, see `build_hash`)
+static char *cache_path(const char *dir, const char *filename, File_Content content) {
+    uint64_t key;
+
+    if (!build_hash(&key)) return NULL;
+
+    char *path = realpath(filename, NULL);
+
+    if (path == NULL) return NULL;
+
+    key = hash_bytes(key, path, strlen(path) + 1);
+    key = hash_bytes(key, content.data, content.size);
+
+    free(path);
+
+    size_t size = strlen(dir) + 32;
+    char *cache = malloc(size);
+
+    snprintf(cache, size, "%s/%016llx.esc", dir, (unsigned long long)key);
+
+    return cache;
+}
+
+static void write_number(String_Builder *out, uint64_t number) {
+    string_builder_append(out, (const char*)&number, sizeof(number));
+}
+
+static void write_string(String_Builder *out, const char *value, size_t size) {
+    write_number(out, size);
+    string_builder_append(out, value, size);
+}
+
+static void write_tag(String_Builder *out, char tag) {
+    string_builder_append(out, &tag, 1);
+}
+
+static bool write_var(String_Builder *out, Var var);
+
+// false when it's not a value (what the interpreter gives is always evaluated, but it's not worth saving otherwise)
+static bool write_argument(String_Builder *out, Argument arg) {
+    switch (arg.kind) {
+        case AK_NIL: write_tag(out, 'n'); return true;
+        case AK_INTEGER: write_tag(out, 'i'); write_number(out, arg.as.integer.value); return true;
+        case AK_FLOAT: write_tag(out, 'f'); string_builder_append(out, (const char*)&arg.as.floating.value, sizeof(double)); return true;
+        case AK_BOOLEAN: write_tag(out, 'b'); write_number(out, arg.as.boolean.value); return true;
+        case AK_STRING: write_tag(out, 's'); write_string(out, arg.as.string.value, arg.as.string.size); return true;
+        case AK_ARRAY: {
+            if (!arg.evaluated) return false;
+
+            write_tag(out, 'a');
+            write_number(out, arg.as.array.length);
+
+            for (size_t i = 0; i < arg.as.array.length; ++i) {
+                if (!write_argument(out, array_at(arg.as.array, i))) return false;
+            }
+
+            return true;
+        }
+        case AK_OBJECT: {
+            if (!arg.evaluated) return false;
+
+            write_tag(out, 'o');
+            write_number(out, arg.as.object.length);
+
+            for (size_t i = 0; i < arg.as.object.length; ++i) {
+                if (!write_var(out, arg.as.object.data[i])) return false;
+            }
+
+            return true;
+        }
+        default: return false;
+    }
+}
+
+// The name and the value
+static bool write_var(String_Builder *out, Var var) {
+    Argument arg = {.evaluated = var.evaluated};
+
+    switch (var.kind) {
+        case VK_NIL: arg.kind = AK_NIL; break;
+        case VK_INTEGER: arg.kind = AK_INTEGER; arg.as.integer = var.as.integer; break;
+        case VK_FLOAT: arg.kind = AK_FLOAT; arg.as.floating = var.as.floating; break;
+        case VK_BOOLEAN: arg.kind = AK_BOOLEAN; arg.as.boolean = var.as.boolean; break;
+        case VK_STRING: arg.kind = AK_STRING; arg.as.string = var.as.string; break;
+        case VK_ARRAY: arg.kind = AK_ARRAY; arg.as.array = var.as.array; break;
+        case VK_OBJECT: arg.kind = AK_OBJECT; arg.as.object = var.as.object; break;
+        default: return false;
+    }
+
+    write_string(out, var.name.value, var.name.size);
+
+    return write_argument(out, arg);
+}
+
+void cache_store(const char *dir, const char *filename, File_Content content, Interpreter *interpreter) {
+    char *path = cache_path(dir, filename, content);
+
+    if (path == NULL) return;
+
+    String_Builder out = {0};
+    bool ok = true;
+
+    string_builder_append(&out, CACHE_MAGIC, 4);
+    write_number(&out, CACHE_FORMAT);
+    // the key is the name of the file, but the name could be anything
+    write_string(&out, path + strlen(dir) + 1, 16);
+
+    size_t imports = imports_length();
+
+    write_number(&out, imports);
+
+    for (size_t i = 0; i < imports; ++i) {
+        Import *import = imports_get(i);
+
+        write_string(&out, import->path, strlen(import->path));
+        write_number(&out, hash_bytes(0, import->content.data, import->content.size));
+    }
+
+    size_t length = interpreter_symbols_length(interpreter);
+
+    write_number(&out, length);
+
+    for (size_t i = 0; i < length && ok; ++i) {
+        ok = write_var(&out, interpreter_symbol(interpreter, i));
+    }
+
+    (void)mkdir(dir, 0777);
+
+    size_t temporary_size = strlen(path) + 32;
+    char *temporary = malloc(temporary_size);
+
+    snprintf(temporary, temporary_size, "%s.%ld.tmp", path, (long)getpid());
+
+    FILE *file = ok ? fopen(temporary, "wb") : NULL;
+
+    if (file != NULL) {
+        ok = fwrite(out.data, 1, out.length, file) == out.length;
+        ok = fclose(file) == 0 && ok;
+
+        if (!ok || rename(temporary, path) != 0) unlink(temporary);
+    }
+
+    free(temporary);
+    free(out.data);
+    free(path);
+}
+
+typedef struct {
+    const char *data;
+    size_t size, position;
+    // it's not what we wrote (a broken or truncated file), then everything is read as zeros
+    bool ok;
+} Reader;
+
+static const char *read_bytes(Reader *reader, size_t size) {
+    if (!reader->ok || size > reader->size - reader->position) {
+        reader->ok = false;
+        return NULL;
+    }
+
+    const char *bytes = reader->data + reader->position;
+
+    reader->position += size;
+
+    return bytes;
+}
+
+static uint64_t read_number(Reader *reader) {
+    uint64_t number = 0;
+    const char *bytes = read_bytes(reader, sizeof(number));
+
+    if (bytes != NULL) memcpy(&number, bytes, sizeof(number));
+
+    return number;
+}
+
+static String read_string(Reader *reader) {
+    size_t size = read_number(reader);
+    const char *value = read_bytes(reader, size);
+
+    return (String){.value = (char*)value, .size = value != NULL ? size : 0};
+}
+
+// The number of items that follow, which can't be more than what is left of the file (each one takes a byte at least)
+static size_t read_length(Reader *reader) {
+    size_t length = read_number(reader);
+
+    if (length > reader->size - reader->position) {
+        reader->ok = false;
+        return 0;
+    }
+
+    return length;
+}
+
+static Var read_var(Reader *reader, Arena *arena);
+
+// Everything is already evaluated, so the locations are never needed
+static Argument read_argument(Reader *reader, Arena *arena) {
+    const char *tag = read_bytes(reader, 1);
+    Argument arg = {.kind = AK_NIL, .evaluated = true};
+
+    if (tag == NULL) return arg;
+
+    switch (*tag) {
+        case 'n': break;
+        case 'i': arg.kind = AK_INTEGER; arg.as.integer.value = read_number(reader); break;
+        case 'f': {
+            arg.kind = AK_FLOAT;
+
+            const char *bytes = read_bytes(reader, sizeof(double));
+
+            if (bytes != NULL) memcpy(&arg.as.floating.value, bytes, sizeof(double));
+        } break;
+        case 'b': arg.kind = AK_BOOLEAN; arg.as.boolean.value = read_number(reader) != 0; break;
+        case 's': arg.kind = AK_STRING; arg.as.string = read_string(reader); break;
+        case 'a': {
+            size_t length = read_length(reader);
+
+            arg.kind = AK_ARRAY;
+            arg.as.array = (Array){.length = length, .capacity = length, .data = arena_alloc(arena, length * sizeof(Argument))};
+
+            for (size_t i = 0; i < length; ++i) arg.as.array.data[i] = read_argument(reader, arena);
+        } break;
+        case 'o': {
+            size_t length = read_length(reader);
+
+            arg.kind = AK_OBJECT;
+            arg.as.object = (Object){.length = length, .capacity = length, .data = arena_alloc(arena, length * sizeof(Var))};
+
+            for (size_t i = 0; i < length; ++i) arg.as.object.data[i] = read_var(reader, arena);
+        } break;
+        default: reader->ok = false; break;
+    }
+
+    return arg;
+}
+
+static Var read_var(Reader *reader, Arena *arena) {
+    String name = read_string(reader);
+    Argument arg = read_argument(reader, arena);
+    Var var = {.name = name, .evaluated = true};
+
+    switch (arg.kind) {
+        case AK_INTEGER: var.kind = VK_INTEGER; var.as.integer = arg.as.integer; break;
+        case AK_FLOAT: var.kind = VK_FLOAT; var.as.floating = arg.as.floating; break;
+        case AK_BOOLEAN: var.kind = VK_BOOLEAN; var.as.boolean = arg.as.boolean; break;
+        case AK_STRING: var.kind = VK_STRING; var.as.string = arg.as.string; break;
+        case AK_ARRAY: var.kind = VK_ARRAY; var.as.array = arg.as.array; break;
+        case AK_OBJECT: var.kind = VK_OBJECT; var.as.object = arg.as.object; break;
+        default: var.kind = VK_NIL; break;
+    }
+
+    return var;
+}
+
+static void skip_string(Reader *reader) {
+    (void)read_bytes(reader, read_number(reader));
+}
+
+// The same as `read_argument` without making anything, to check the whole file and find where the vars start
+static void skip_argument(Reader *reader) {
+    const char *tag = read_bytes(reader, 1);
+
+    if (tag == NULL) return;
+
+    switch (*tag) {
+        case 'n': break;
+        case 'i': case 'f': case 'b': (void)read_bytes(reader, 8); break;
+        case 's': skip_string(reader); break;
+        case 'a': {
+            size_t length = read_length(reader);
+
+            for (size_t i = 0; i < length && reader->ok; ++i) skip_argument(reader);
+        } break;
+        case 'o': {
+            size_t length = read_length(reader);
+
+            for (size_t i = 0; i < length && reader->ok; ++i) {
+                skip_string(reader);
+                skip_argument(reader);
+            }
+        } break;
+        default: reader->ok = false; break;
+    }
+}
+
+// The part of the cache before the vars: whether it's of this format and none of the imports changed since
+static bool read_header(Reader *reader, const char *path, const char *dir) {
+    const char *magic = read_bytes(reader, 4);
+
+    if (magic == NULL || memcmp(magic, CACHE_MAGIC, 4) != 0) return false;
+    if (read_number(reader) != CACHE_FORMAT) return false;
+
+    String key = read_string(reader);
+
+    if (!reader->ok || !cmp_sized_strings(key.value, key.size, path + strlen(dir) + 1, 16)) return false;
+
+    size_t imports = read_length(reader);
+
+    for (size_t i = 0; i < imports && reader->ok; ++i) {
+        String import = read_string(reader);
+        uint64_t saved = read_number(reader);
+
+        if (!reader->ok) return false;
+
+        char *import_path = strndup(import.value, import.size);
+        uint64_t hash;
+        bool same = hash_file(import_path, &hash) && hash == saved;
+
+        free(import_path);
+
+        if (!same) return false;
+    }
+
+    return reader->ok;
+}
+
+bool cache_load(Cache *cache, const char *dir, const char *filename, File_Content content) {
+    *cache = (Cache){0};
+
+    char *path = cache_path(dir, filename, content);
+
+    if (path == NULL) return false;
+
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+
+    if (fd < 0 || fstat(fd, &info) < 0 || info.st_size == 0) {
+        if (fd >= 0) close(fd);
+        free(path);
+        return false;
+    }
+
+    char *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        free(path);
+        return false;
+    }
+
+    cache->data = data;
+    cache->size = info.st_size;
+
+    Reader reader = {.data = data, .size = info.st_size, .ok = true};
+
+    if (read_header(&reader, path, dir)) {
+        cache->length = read_length(&reader);
+        cache->offsets = malloc(cache->length * sizeof(size_t));
+
+        for (size_t i = 0; i < cache->length && reader.ok; ++i) {
+            cache->offsets[i] = reader.position;
+
+            skip_string(&reader);
+            skip_argument(&reader);
+        }
+    }
+
+    free(path);
+
+    // anything else is not what we wrote, it's overwritten by the next `cache_store`
+    if (!reader.ok || reader.position != reader.size) {
+        cache_free(cache);
+        return false;
+    }
+
+    return true;
+}
+
+String cache_name(Cache *cache, size_t i) {
+    Reader reader = {.data = cache->data, .size = cache->size, .position = cache->offsets[i], .ok = true};
+
+    return read_string(&reader);
+}
+
+Var cache_var(Cache *cache, size_t i) {
+    Reader reader = {.data = cache->data, .size = cache->size, .position = cache->offsets[i], .ok = true};
+
+    // only one at a time, so printing a huge table takes the memory of its biggest var
+    arena_free(&cache->arena);
+
+    return read_var(&reader, &cache->arena);
+}
+
+void cache_free(Cache *cache) {
+    if (cache->data != NULL) munmap(cache->data, cache->size);
+
+    free(cache->offsets);
+
+    arena_free(&cache->arena);
+
+    *cache = (Cache){0};
+}
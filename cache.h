@@ -0,0 +1,42 @@
+#ifndef CACHE_H_
+#define CACHE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "./io.h"
+#include "./parser.h"
+#include "./arena.h"
+#include "./interpreter.h"
+
+// The symbols table of a file saved on disk (in EVALSET_CACHE_DIR), so the next runs on the same file print it
+// without lexing, parsing nor evaluating anything.
+//
+// A cache is found by a hash of the evalset executable, the path of the file and its content. It also keeps
+// the hash of every file that was imported, they are checked before it's used. The cache file is mapped and
+// the vars are read from it only when they are printed, their strings point right into it.
+typedef struct {
+    char *data;
+    size_t size;
+
+    // The symbols table, in the same order as `interpret` prints it: where each var starts in the file.
+    // They are only read by `cache_var`, one at a time.
+    size_t *offsets;
+    size_t length;
+
+    // the arrays and objects of the last var read
+    Arena arena;
+} Cache;
+
+// Whether there is a cache of the file with this content, made by this build, whose imports didn't change
+bool cache_load(Cache *cache, const char *dir, const char *filename, File_Content content);
+// The symbols table of the interpreter (everything must be evaluated) and the files imported so far.
+// It's written to a temporary file and then renamed, so the runs at the same time never see half of it.
+// Failing to save it is not an error, the next run just won't find it.
+void cache_store(const char *dir, const char *filename, File_Content content, Interpreter *interpreter);
+// The name of the i-th var, without reading its value
+String cache_name(Cache *cache, size_t i);
+// The i-th var with its value (see `Var.evaluated`), it's valid until the next call
+Var cache_var(Cache *cache, size_t i);
+void cache_free(Cache *cache);
+
+#endif // !CACHE_H_
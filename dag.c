@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include "./dag.h"
+
+typedef struct {
+    Dag *dag;
+    void (*run)(void *context, size_t task);
+    void *context;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t ready_cond;
+
+    // tasks with nothing to wait for
+    size_t *ready;
+    size_t ready_length;
+    size_t done;
+} Dag_Run;
+
+static void *checked_calloc(size_t count, size_t size) {
+    void *output = calloc(count, size);
+
+    if (output == NULL) {
+        fprintf(stderr, "Error: Failed to allocate memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return output;
+}
+
+Dag dag_new(size_t length, const Dag_Edge *edges, size_t edges_length) {
+    Dag dag = {
+        .length = length,
+        .pending = checked_calloc(length, sizeof(size_t)),
+        .first = checked_calloc(length + 1, sizeof(size_t)),
+        .dependents = checked_calloc(edges_length, sizeof(size_t)),
+    };
+
+    // counting sort of the edges by `from`
+    for (size_t i = 0; i < edges_length; ++i) {
+        dag.first[edges[i].from + 1]++;
+        dag.pending[edges[i].to]++;
+    }
+
+    for (size_t i = 0; i < length; ++i) dag.first[i + 1] += dag.first[i];
+
+    size_t *next = checked_calloc(length, sizeof(size_t));
+
+    for (size_t i = 0; i < edges_length; ++i) {
+        size_t from = edges[i].from;
+
+        dag.dependents[dag.first[from] + next[from]++] = edges[i].to;
+    }
+
+    free(next);
+
+    return dag;
+}
+
+static void *worker(void *arg) {
+    Dag_Run *state = arg;
+    Dag *dag = state->dag;
+
+    pthread_mutex_lock(&state->mutex);
+
+    while (true) {
+        while (state->ready_length == 0 && state->done < dag->length) {
+            pthread_cond_wait(&state->ready_cond, &state->mutex);
+        }
+
+        if (state->done == dag->length) break;
+
+        size_t task = state->ready[--state->ready_length];
+
+        pthread_mutex_unlock(&state->mutex);
+
+        state->run(state->context, task);
+
+        pthread_mutex_lock(&state->mutex);
+
+        state->done++;
+
+        size_t woken = 0;
+
+        for (size_t i = dag->first[task]; i < dag->first[task + 1]; ++i) {
+            size_t dependent = dag->dependents[i];
+
+            if (--dag->pending[dependent] == 0) {
+                state->ready[state->ready_length++] = dependent;
+                woken++;
+            }
+        }
+
+        // this thread takes one of them, the others are for whoever is waiting
+        if (woken > 1) pthread_cond_broadcast(&state->ready_cond);
+        else if (state->done == dag->length) pthread_cond_broadcast(&state->ready_cond);
+    }
+
+    pthread_mutex_unlock(&state->mutex);
+
+    return NULL;
+}
+
+void dag_run(Dag *dag, size_t threads, void (*run)(void *context, size_t task), void *context) {
+    Dag_Run state = {
+        .dag = dag,
+        .run = run,
+        .context = context,
+        .ready = checked_calloc(dag->length > 0 ? dag->length : 1, sizeof(size_t)),
+    };
+
+    pthread_mutex_init(&state.mutex, NULL);
+    pthread_cond_init(&state.ready_cond, NULL);
+
+    // pushed backwards, so the first tasks are the first ones to be taken
+    for (size_t i = dag->length; i > 0; --i) {
+        if (dag->pending[i - 1] == 0) state.ready[state.ready_length++] = i - 1;
+    }
+
+    pthread_t *workers = checked_calloc(threads > 1 ? threads - 1 : 1, sizeof(pthread_t));
+    size_t started = 0;
+
+    for (size_t i = 0; i + 1 < threads; ++i) {
+        if (pthread_create(&workers[started], NULL, worker, &state) != 0) break;
+
+        started++;
+    }
+
+    worker(&state);
+
+    for (size_t i = 0; i < started; ++i) pthread_join(workers[i], NULL);
+
+    pthread_cond_destroy(&state.ready_cond);
+    pthread_mutex_destroy(&state.mutex);
+    free(workers);
+    free(state.ready);
+}
+
+void dag_free(Dag *dag) {
+    free(dag->pending);
+    free(dag->first);
+    free(dag->dependents);
+}
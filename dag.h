@@ -0,0 +1,29 @@
+#ifndef DAG_H_
+#define DAG_H_
+
+#include <stddef.h>
+
+// Runs tasks that depend on each other on a pool of threads. A task only starts once every task it
+// depends on is done, tasks with nothing left to wait for run in any order (and at the same time).
+
+typedef struct {
+    size_t from, to; // `to` depends on `from`
+} Dag_Edge;
+
+typedef struct {
+    size_t length;
+    // how many tasks each task is still waiting for
+    size_t *pending;
+    // the tasks waiting for task i are dependents[first[i]] up to dependents[first[i + 1]]
+    size_t *first;
+    size_t *dependents;
+} Dag;
+
+// The edges must not make a cycle
+Dag dag_new(size_t length, const Dag_Edge *edges, size_t edges_length);
+// `run` is called once for each task, from `threads` threads (the caller is one of them).
+// It returns when every task is done. The dag can't be run again.
+void dag_run(Dag *dag, size_t threads, void (*run)(void *context, size_t task), void *context);
+void dag_free(Dag *dag);
+
+#endif // !DAG_H_
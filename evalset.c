@@ -2,11 +2,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include "./lexer.h"
 #include "./parser.h"
 #include "./io.h"
+#include "./stream.h"
 #include "./print.h"
 #include "./interpreter.h"
+#include "./import.h"
+#include "./cache.h"
+#include "./map.h"
 #include "utils.h"
 
 #define arg() shift(&argc, &argv)
@@ -18,7 +23,145 @@ char *shift(int *argc, char ***argv) {
 }
 
 void usage(FILE *stream, const char *program_name) {
-    fprintf(stream, "usage: %s <filename> [--format]\n", program_name);
+    fprintf(stream, "usage: %s <filename> [--format | --get <name>... | --stream]\n", program_name);
+    fprintf(stream, "  <filename>        it can be - to read from the standard input\n");
+    fprintf(stream, "  --format          print the file formatted\n");
+    fprintf(stream, "  --get <name>...   evaluate only these vars (and the ones they reference) and print them\n");
+    fprintf(stream, "  --stream          print each var as soon as it's read, in order, and release it unless another\n");
+    fprintf(stream, "                    var references it (instead of the symbols table). From the standard input or a\n");
+    fprintf(stream, "                    pipe what is referenced can't be known in advance, so nothing is released:\n");
+    fprintf(stream, "                    the memory grows with the input, give the path of a file to keep it bounded\n");
+    fprintf(stream, "set EVALSET_CACHE_DIR to save what is evaluated there, the next runs on the same file only print it\n");
+}
+
+// The standard input and pipes are read a piece at a time (see stream.h), the rest is mapped whole
+static bool is_stream(const char *filename) {
+    struct stat info;
+
+    return strcmp(filename, "-") == 0 || (stat(filename, &info) == 0 && !S_ISREG(info.st_mode) && !S_ISDIR(info.st_mode));
+}
+
+// Reads, evaluates and prints a var at a time, so only the vars that are referenced stay in memory.
+// A var can be referenced by any var after it, so without the first pass (from a pipe) all of them stay.
+static int evaluate_stream(const char *filename) {
+    Arena names_arena = {0};
+    Map *referenced = stream_referenced_names(filename, &names_arena);
+    Stream stream = stream_open(filename);
+    Interpreter *interpreter = interpreter_stream_new();
+    // the batches with a var that is referenced later, the others are released right after they are printed
+    struct { size_t length, capacity; Parser *data; } kept = {0};
+    Token *batch;
+
+    while ((batch = stream_next(&stream))) {
+        Parser parser = {0};
+        bool keep_batch = false;
+
+        parse_tokens_batch(&parser, batch);
+        parse_tokens_finish(&parser);
+
+        for (size_t i = 0; i < parser.length; ++i) {
+            const Var *var = &parser.vars[i];
+            // without a first pass (from a pipe) anything could be referenced later
+            bool keep = referenced == NULL || map_get(referenced, var->name.value, var->name.size) != NULL;
+
+            interpreter_stream_var(interpreter, var, &parser.arena, keep);
+
+            keep_batch = keep_batch || keep;
+        }
+
+        if (keep_batch) {
+            array_append(&kept, parser);
+        } else {
+            parser_free(parser);
+            stream_forget_batch(&stream);
+        }
+    }
+
+    int status = stream.lexer.errors > 0 ? 1 : 0;
+
+    interpreter_free(interpreter);
+    imports_free();
+
+    for (size_t i = 0; i < kept.length; ++i) parser_free(kept.data[i]);
+
+    array_free(&kept);
+    stream_close(&stream);
+
+    if (referenced != NULL) map_free(referenced);
+
+    arena_free(&names_arena);
+
+    return status;
+}
+
+// EVALSET_CACHE_DIR: the symbols table is saved the first time, and only printed by the next runs (see cache.h).
+// So even with --get, everything is evaluated the first time.
+static int evaluate_cached(const char *filename, const char *cache_dir, bool get, int *argc, char ***argv) {
+    File_Content content = read_from_file(filename);
+    Cache cache = {0};
+    Lexer lexer = {0};
+    Parser parser = {0};
+    Interpreter *interpreter = NULL;
+    bool cached = cache_load(&cache, cache_dir, filename, content);
+    size_t length;
+
+    if (cached) {
+        length = cache.length;
+    } else {
+        lexer = create_lexer(filename, content.data, content.size);
+
+        Token *head = lex(&lexer);
+
+        parser = parse_tokens(head);
+        interpreter = interpreter_new(parser.vars, parser.length);
+        interpreter_evaluate_all(interpreter);
+
+        // the errors of the lexer are shown every time
+        if (head != NULL) cache_store(cache_dir, filename, content, interpreter);
+
+        length = interpreter_symbols_length(interpreter);
+    }
+
+    #define symbol_name(i) (cached ? cache_name(&cache, (i)) : interpreter_symbol(interpreter, (i)).name)
+    #define symbol(i) (cached ? cache_var(&cache, (i)) : interpreter_symbol(interpreter, (i)))
+
+    int status = 0;
+
+    if (get) {
+        const char *name;
+
+        while ((name = shift(argc, argv)) != NULL) {
+            size_t i = 0;
+
+            while (i < length && !cmp_sized_strings(symbol_name(i).value, symbol_name(i).size, name, strlen(name))) ++i;
+
+            if (i < length) {
+                print_evaluated_var(symbol(i));
+            } else {
+                fprintf(stderr, "%s: variable \033[1;35m%s\033[0m not found\n", filename, name);
+                status = 1;
+            }
+        }
+    } else {
+        printf("Symbols table (%ld)\n", length);
+
+        for (size_t i = 0; i < length; ++i) print_evaluated_var(symbol(i));
+    }
+
+    #undef symbol_name
+    #undef symbol
+
+    if (interpreter != NULL) {
+        interpreter_free(interpreter);
+        imports_free();
+        parser_free(parser);
+        lexer_free(&lexer);
+    }
+
+    cache_free(&cache);
+    file_content_free(&content);
+
+    return status;
 }
 
 int main(int argc, char **argv) {
@@ -32,21 +175,41 @@ int main(int argc, char **argv) {
         return 1;
     }
 
-    char *content;
+    if (flag != NULL && cmp_sized_strings(flag, strlen(flag), "--stream", 8)) return evaluate_stream(filename);
 
-    size_t data_size = read_from_file(filename, &content);
+    bool streamed = is_stream(filename);
+    bool get = flag != NULL && cmp_sized_strings(flag, strlen(flag), "--get", 5);
+    bool format = flag != NULL && cmp_sized_strings(flag, strlen(flag), "--format", 8);
+    const char *cache_dir = getenv("EVALSET_CACHE_DIR");
 
-    Lexer lexer = create_lexer(filename, content, data_size);
+    if (cache_dir != NULL && *cache_dir != '\0' && !streamed && !format) {
+        return evaluate_cached(filename, cache_dir, get, &argc, &argv);
+    }
 
-    Token *head;
+    Stream stream = {0};
+    File_Content content = {0};
+    Lexer lexer = {0};
+    Parser parser;
 
-    if ((head = lex(&lexer))) {
-        print_tokens(head);
+    if (streamed) {
+        stream = stream_open(filename);
+        parser = parse_stream(&stream);
+    } else {
+        content = read_from_file(filename);
+        lexer = create_lexer(filename, content.data, content.size);
+
+        Token *head;
+
+        if ((head = lex(&lexer))) {
+            print_tokens(head);
+        }
+
+        parser = parse_tokens(head);
     }
 
-    Parser parser = parse_tokens(head);
+    int status = 0;
 
-    if (flag != NULL && cmp_sized_strings(flag, strlen(flag), "--format", 8)) {
+    if (format) {
         for (size_t i = 0; i < parser.length; i++) {
             Var var = parser.vars[i];
 
@@ -54,12 +217,31 @@ int main(int argc, char **argv) {
 
             if (i < parser.length - 1) printf("\n");
         }
+    } else if (get) {
+        Interpreter *interpreter = interpreter_new(parser.vars, parser.length);
+        const char *name;
+
+        while ((name = arg()) != NULL) {
+            if (!interpreter_print(interpreter, name, strlen(name))) {
+                fprintf(stderr, "%s: variable \033[1;35m%s\033[0m not found\n", filename, name);
+                status = 1;
+            }
+        }
+
+        interpreter_free(interpreter);
     } else {
         interpret(parser.vars, parser.length);
     }
 
+    imports_free();
     parser_free(parser);
-    lexer_free(&lexer);
 
-    return 0;
+    if (streamed) {
+        stream_close(&stream);
+    } else {
+        lexer_free(&lexer);
+        file_content_free(&content);
+    }
+
+    return status;
 }
@@ -0,0 +1,132 @@
+#include "./import.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <libgen.h>
+#include <limits.h>
+#include "./map.h"
+#include "./utils.h"
+
+// path -> Import*
+static Map *imports = NULL;
+static pthread_mutex_t imports_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// The path of `filename` from the directory of the file `from` is in
+static char *resolve_path(const char *filename, Location from) {
+    char path[PATH_MAX];
+
+    if (filename[0] == '/') {
+        snprintf(path, sizeof(path), "%s", filename);
+    } else {
+        // dirname can modify what it gets
+        char importer[PATH_MAX];
+
+        snprintf(importer, sizeof(importer), "%s", loc_filename(from));
+        snprintf(path, sizeof(path), "%s/%s", dirname(importer), filename);
+    }
+
+    char *resolved = realpath(path, NULL);
+
+    if (resolved == NULL) {
+        fprintf(stderr, LOC_ERROR_FMT" could not import \033[1;35m%s\033[0m: %s\n", LOC_ERROR_ARG(from), filename, strerror(errno));
+        exit(1);
+    }
+
+    return resolved;
+}
+
+// The entry of the file, it's only created here so every importer gets the same one
+static Import *find_import(char *path) {
+    pthread_mutex_lock(&imports_lock);
+
+    if (imports == NULL) imports = map_new(sizeof(Import*));
+
+    Import **found = map_get(imports, path, strlen(path));
+    Import *import;
+
+    if (found != NULL) {
+        import = *found;
+        free(path);
+    } else {
+        import = calloc(1, sizeof(Import));
+        assert(import != NULL && "failed to allocate import");
+
+        import->path = path;
+        pthread_mutex_init(&import->lock, NULL);
+
+        map_set(imports, import->path, strlen(import->path), &import);
+    }
+
+    pthread_mutex_unlock(&imports_lock);
+
+    return import;
+}
+
+Import *import_load(const char *filename, Location from) {
+    Import *import = find_import(resolve_path(filename, from));
+
+    // the others importing it at the same time wait for the first one to finish
+    pthread_mutex_lock(&import->lock);
+
+    if (!import->loaded) {
+        import->content = read_from_file(import->path);
+        import->lexer = create_lexer(import->path, import->content.data, import->content.size);
+
+        Token *head = lex(&import->lexer);
+
+        // the errors were shown already
+        if (head == NULL) exit(1);
+
+        import->parser = parse_tokens(head);
+        import->loaded = true;
+    }
+
+    pthread_mutex_unlock(&import->lock);
+
+    return import;
+}
+
+size_t imports_length(void) {
+    pthread_mutex_lock(&imports_lock);
+
+    size_t length = imports != NULL ? imports->length : 0;
+
+    pthread_mutex_unlock(&imports_lock);
+
+    return length;
+}
+
+Import *imports_get(size_t i) {
+    pthread_mutex_lock(&imports_lock);
+
+    Import *import = *(Import**)map_value_at(imports, i);
+
+    pthread_mutex_unlock(&imports_lock);
+
+    return import;
+}
+
+void imports_free(void) {
+    if (imports == NULL) return;
+
+    for (size_t i = 0; i < imports->length; ++i) {
+        Import *import = *(Import**)map_value_at(imports, i);
+
+        if (import->interpreter != NULL) interpreter_free(import->interpreter);
+
+        if (import->loaded) {
+            parser_free(import->parser);
+            lexer_free(&import->lexer);
+            file_content_free(&import->content);
+        }
+
+        pthread_mutex_destroy(&import->lock);
+        free(import->path);
+        free(import);
+    }
+
+    map_free(imports);
+    imports = NULL;
+}
@@ -0,0 +1,40 @@
+#ifndef IMPORT_H_
+#define IMPORT_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include "./io.h"
+#include "./lexer.h"
+#include "./parser.h"
+#include "./interpreter.h"
+
+// A file loaded by `import("path")`. Each file is read, lexed and parsed once per process, no matter how many
+// files import it, and only the first time one of its imports is evaluated (so the files nobody needs are never
+// read). Different files are loaded at the same time when the vars importing them are evaluated by different
+// threads (see EVALSET_THREADS).
+typedef struct {
+    // from realpath, so the different ways to write the path of a file lead to the same import
+    char *path;
+
+    pthread_mutex_t lock;
+    bool loaded;
+    File_Content content;
+    Lexer lexer;
+    Parser parser;
+
+    // Its vars evaluated as an object, set by the interpreter the first time it's imported (see `builtin_import`).
+    bool evaluating, evaluated;
+    Interpreter *interpreter;
+    Object value;
+} Import;
+
+// `filename` is relative to the directory of the file `from` is in, unless it's absolute.
+// It exits when the file can't be read or has errors.
+Import *import_load(const char *filename, Location from);
+// The files imported so far, in the order they were first imported
+size_t imports_length(void);
+Import *imports_get(size_t i);
+// Everything that was imported, the imports must not be used after it
+void imports_free(void);
+
+#endif // !IMPORT_H_
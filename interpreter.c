@@ -1,13 +1,22 @@
 #include "./parser.h"
 #include "./interpreter.h"
 #include "./map.h"
+#include "./object.h"
+#include "./print.h"
 #include "./utils.h"
 #include "./loc.h"
 #include "./assertf.h"
+#include "./dag.h"
+#include "./native.h"
+#include "./simd.h"
+#include "./rope.h"
+#include "./import.h"
+#include <pthread.h>
 #include <string.h>
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <unistd.h>
 
 #define BUILTIN_FUN_SUM_I "sum_i"
 #define BUILTIN_FUN_SUM_F "sum_f"
@@ -19,6 +28,7 @@
 #define BUILTIN_FUN_JOIN_AS "join_as"
 #define BUILTIN_FUN_KEYS "keys"
 #define BUILTIN_FUN_IOTA "iota"
+#define BUILTIN_FUN_IMPORT "import"
 
 typedef enum {
     SK_NIL = 0,
@@ -55,7 +65,56 @@ typedef struct {
     Symbol_Value value;
 } Symbol;
 
-typedef Map* Symbols;
+typedef enum {
+    DS_PENDING = 0,
+    DS_EVALUATING,
+    DS_DONE,
+} Declaration_State;
+
+#define NO_DECLARATION ((size_t)-1)
+// below this, starting the threads costs more than what they could save
+#define PARALLEL_MIN_VARS 64
+
+typedef struct {
+    // the top-level var
+    const Var *var;
+    // the one declared before it with the same name, or NO_DECLARATION
+    size_t previous;
+    Declaration_State state;
+    Symbol_Value value;
+    // iota() gives a different value depending on what was evaluated before, so every item of its
+    // arrays and objects must be evaluated, even when only one is used (see `select_indexes`)
+    bool calls_iota;
+} Declaration;
+
+// The top-level vars, evaluated the first time they are needed (all of them by `interpret`, the independent
+// ones at the same time when there are enough of them).
+// A reference only sees the vars declared before the var being evaluated, no matter the order the vars
+// are evaluated in, so `a = 1, b = $/a, a = 2` still gives b = 1 and referencing a var declared later fails.
+struct Interpreter {
+    Declaration *declarations;
+    size_t length, capacity;
+    // name -> index of its last declaration, in the order the names first appear
+    Map *names;
+    // Where the arrays, objects and strings made by the evaluation go (see `value_alloc`), for the streaming,
+    // where they go away with the var (see `interpreter_stream_var`), and for the imported files
+    // (single-threaded both)
+    Arena *values;
+};
+
+// The top-level var being evaluated by this thread (NO_DECLARATION when there is none, then every var is visible)
+static _Thread_local size_t current_declaration = NO_DECLARATION;
+
+typedef Interpreter* Symbols;
+
+struct Builtin {
+    const char *name;
+    Symbol_Value (*fun)(Symbols symbols, Location loc, Fun_Call *fun_call);
+    // the kind of what it returns, it's used to check the arguments of the natives
+    Native_Kind result;
+    // `call(...)[index]` without making the whole result (NULL when it can't), see `select_indexes`
+    Argument (*at)(Symbols symbols, Location loc, Fun_Call *fun_call, long index, Location index_loc);
+};
 
 Symbol_Value eval_builtin_fun_call(Symbols symbols, Location loc, Fun_Call *fun_call);
 void print_symbol(Symbols *symbols, Symbol symbol, bool is_inside_array);
@@ -63,8 +122,22 @@ Symbol interpret_var(Symbols symbols, Var var);
 Symbol_Value reduce_argument(Symbols symbols, Argument arg);
 Array reduce_array(Symbols symbols, Array root);
 Object reduce_object(Symbols symbols, Object root);
+static Symbol_Value select_indexes(Symbols symbols, Metadata metadata, Argument container, size_t owner);
+
+// Without an arena, the values live as long as the program (like the vars that may keep them)
+static void *value_alloc(Symbols symbols, size_t size) {
+    if (size == 0) return NULL;
+
+    if (symbols->values != NULL) return arena_alloc(symbols->values, size);
+
+    void *data = malloc(size);
+    assert(data != NULL && "failed to allocate value");
 
-static long __builtin_iota_current_value = 0;
+    return data;
+}
+
+// Per thread, the parallel evaluation sets it before each var (see `evaluate_in_parallel`)
+static _Thread_local long __builtin_iota_current_value = 0;
 
 static const char *symbol_kind_name(Symbol_Kind kind) {
     switch (kind) {
@@ -156,118 +229,232 @@ static Argument_Data_Types var_data_type_to_argument_data_type(Var_Kind kind, Va
     }
 }
 
+static void check_index(Location loc, long index, size_t length) {
+    if (index < 0 || (size_t)index >= length) {
+        fprintf(
+            stderr,
+            LOC_ERROR_FMT" index %ld out of range\n",
+            LOC_ERROR_ARG(loc),
+            index
+        );
+        exit(1);
+    }
+}
+
+// The item of the evaluated `value` at `index` (evaluated too), `loc` is the location of the index
+static Symbol_Value index_value(Symbols symbols, Symbol_Value value, Symbol_Value index, Location loc) {
+    switch (index.kind) {
+        case SK_INTEGER: {
+            if (value.kind != SK_ARRAY) {
+                fprintf(
+                    stderr,
+                    LOC_ERROR_FMT" you cannot index a \033[1;35m%s\033[0m with an integer",
+                    LOC_ERROR_ARG(loc),
+                    symbol_kind_name(value.kind)
+                );
+                exit(1);
+            }
+
+            check_index(loc, index.as.integer.value, value.as.array.length);
+
+            Argument new_value = array_at(value.as.array, index.as.integer.value);
+
+            return reduce_argument(symbols, new_value);
+        }
+        case SK_STRING: {
+            if (value.kind != SK_OBJECT) {
+                fprintf(
+                    stderr,
+                    LOC_ERROR_FMT" You cannot index \033[1;35m%s\033[0m with \"%.*s\"\n",
+                    LOC_ERROR_ARG(loc),
+                    symbol_kind_name(value.kind),
+                    (int)index.as.string.size,
+                    index.as.string.value
+                );
+                exit(1);
+            }
+
+            Var *var = object_get(value.as.object, index.as.string.value, index.as.string.size);
+
+            if (var == NULL) {
+                fprintf(
+                    stderr,
+                    LOC_ERROR_FMT" key \"\033[1;35m%.*s\033[0m\" not found\n",
+                    LOC_ERROR_ARG(loc),
+                    (int)index.as.string.size,
+                    index.as.string.value
+                );
+
+                exit(1);
+            }
+
+            return interpret_var(symbols, *var).value;
+        }
+        default: {
+            fprintf(
+                stderr,
+                LOC_ERROR_FMT" Invalid index value of kind \033[1;35m%s\033[0m\n",
+                LOC_ERROR_ARG(loc),
+                symbol_kind_name(value.kind)
+            );
+            exit(1);
+        }
+    }
+}
+
 Symbol_Value compute_indexing(Symbols symbols, Metadata metadata, Symbol_Value initial) {
     Symbol_Value value = initial;
 
     for (size_t i = 0; i < metadata.indexes.length; ++i) {
         Argument arg = metadata.indexes.data[i];
-        Symbol_Value index = reduce_argument(symbols, metadata.indexes.data[i]);
+        Symbol_Value index = reduce_argument(symbols, arg);
 
-        switch (index.kind) {
-            case SK_INTEGER: {
-                if (value.kind != SK_ARRAY) {
-                    fprintf(
-                        stderr,
-                        LOC_ERROR_FMT" you cannot index a \033[1;35m%s\033[0m with an integer",
-                        LOC_ERROR_ARG(arg.loc),
-                        symbol_kind_name(value.kind)
-                    );
-                    exit(1);
-                }
+        value = index_value(symbols, value, index, arg.loc);
+    }
 
-                if (index.as.integer.value < 0 || (size_t)index.as.integer.value >= value.as.array.length) {
-                    fprintf(
-                        stderr,
-                        LOC_ERROR_FMT" index %ld out of range\n",
-                        LOC_ERROR_ARG(arg.loc),
-                        index.as.integer.value
-                    );
-                    exit(1);
-                }
+    return value;
+}
 
-                Argument new_value = value.as.array.data[index.as.integer.value];
+// Whether the items of the arrays and objects of a declaration can be left unevaluated when they are not used
+static bool can_skip_items(Symbols symbols, size_t declaration) {
+    return declaration != NO_DECLARATION && !symbols->declarations[declaration].calls_iota;
+}
 
-                value = reduce_argument(symbols, new_value);
-            } break;
-            case SK_STRING: {
-                if (value.kind != SK_OBJECT) {
-                    fprintf(
-                        stderr,
-                        LOC_ERROR_FMT" You cannot index \033[1;35m%s\033[0m with \"%s\"\n",
-                        LOC_ERROR_ARG(arg.loc),
-                        symbol_kind_name(value.kind),
-                        index.as.string.value
-                    );
-                    exit(1);
-                }
+static Symbol_Value *evaluate_declaration(Symbols symbols, size_t index) {
+    Declaration *declaration = &symbols->declarations[index];
 
-                bool found = false;
+    if (declaration->state == DS_DONE) return &declaration->value;
 
-                // TODO: change object to a map
-                for (size_t i = 0; i < value.as.object.length; ++i) {
-                    Var var = value.as.object.data[i];
+    // references only go backwards, so it can't happen, but better safe than stack overflow
+    assertf(declaration->state != DS_EVALUATING, "cyclic reference");
 
-                    if (cmp_sized_strings(var.name.value, var.name.size, index.as.string.value, index.as.string.size)) {
-                        found = true;
-                        value = interpret_var(symbols, var).value;
-                        break;
-                    }
-                }
+    size_t current = current_declaration;
 
-                if (!found) {
-                    fprintf(
-                        stderr,
-                        LOC_ERROR_FMT" key \"\033[1;35m%s\033[0m\" not found\n",
-                        LOC_ERROR_ARG(arg.loc),
-                        index.as.string.value
-                    );
+    declaration->state = DS_EVALUATING;
+    current_declaration = index;
 
-                    exit(1);
-                }
-            } break;
-            default: {
-                fprintf(
-                    stderr,
-                    LOC_ERROR_FMT" Invalid index value of kind \033[1;35m%s\033[0m\n",
-                    LOC_ERROR_ARG(arg.loc),
-                    symbol_kind_name(value.kind)
-                );
-                exit(1);
-            } break;
-        }
+    declaration->value = interpret_var(symbols, *declaration->var).value;
+
+    current_declaration = current;
+    declaration->state = DS_DONE;
+
+    return &declaration->value;
+}
+
+// The last declaration of `name` before the declaration `before`, or NO_DECLARATION
+static size_t find_declaration(Symbols symbols, const char *name, size_t name_size, size_t before) {
+    size_t *last = map_get(symbols->names, name, name_size);
+
+    if (last == NULL) return NO_DECLARATION;
+
+    size_t index = *last;
+
+    while (index != NO_DECLARATION && index >= before) {
+        index = symbols->declarations[index].previous;
     }
 
-    return value;
+    return index;
+}
+
+// The value of the last var named `name` declared before the current one (evaluating it if it wasn't yet)
+static Symbol_Value *lookup_symbol(Symbols symbols, const char *name, size_t name_size) {
+    size_t index = find_declaration(symbols, name, name_size, current_declaration);
+
+    if (index == NO_DECLARATION) return NULL;
+
+    return evaluate_declaration(symbols, index);
+}
+
+// Whether `$/name[...]` can pick the items out of the var instead of evaluating all of it first
+static bool can_select_in_declaration(Symbols symbols, size_t index) {
+    Declaration *declaration = &symbols->declarations[index];
+    const Var *var = declaration->var;
+
+    // once it's evaluated, the items are just read
+    if (declaration->state != DS_PENDING || !can_skip_items(symbols, index)) return false;
+    if (var->metadata.indexes.length > 0) return false;
+
+    switch (var->kind) {
+        case VK_ARRAY: case VK_OBJECT: return true;
+        case VK_FUN_CALL: return var->as.fun_call->builtin != NULL && var->as.fun_call->builtin->at != NULL;
+        default: return false;
+    }
 }
 
 Symbol_Value compute_variable_reference(Symbols symbols, Location loc, Path path, Metadata metadata) {
-    if (path.length != 1) {
+    // resolved when the file was loaded (see `bind_path`)
+    Path_Route *route = path.route;
+    size_t index = route->declaration;
+
+    if (index == NO_DECLARATION) {
         fprintf(
             stderr,
-            LOC_ERROR_FMT" invalid path reference",
-            LOC_ERROR_ARG(loc)
+            LOC_ERROR_FMT" variable reference \033[1;35m%.*s\033[0m not found\n",
+            LOC_ERROR_ARG(loc),
+            (int)path.data[0].size,
+            path.data[0].value
         );
         exit(1);
     }
 
-    String chunk = path.data[0];
+    // a var nobody needed whole yet (see `interpreter_print`)
+    if ((path.length > 1 || metadata.indexes.length > 0) && can_select_in_declaration(symbols, index)) {
+        const Var *var = symbols->declarations[index].var;
+        size_t chunk = 1;
 
-    Symbol *symbol = map_get(symbols, chunk.value);
+        while (chunk < path.length && route->slots[chunk - 1] != PATH_NO_SLOT) {
+            var = &var->as.object.data[route->slots[chunk - 1]];
+            chunk++;
+        }
 
-    if (symbol == NULL) {
-        fprintf(
-            stderr,
-            LOC_ERROR_FMT" variable reference \033[1;35m%s\033[0m not found\n",
-            LOC_ERROR_ARG(loc),
-            chunk.value
-        );
-        exit(1);
+        if (chunk == path.length) {
+            Argument container = {
+                .kind = var_kind_to_argument_kind(var->kind),
+                .loc = var->loc,
+                .metadata = var->metadata,
+                .as = var_data_type_to_argument_data_type(var->kind, var->as),
+                .evaluated = var->evaluated
+            };
+
+            return select_indexes(symbols, metadata, container, index);
+        }
+    }
+
+    Symbol_Value value = *evaluate_declaration(symbols, index);
+
+    for (size_t chunk = 1; chunk < path.length; ++chunk) {
+        size_t slot = route->slots[chunk - 1];
+
+        // the evaluated object has the keys of the literal, in the same order
+        if (slot != PATH_NO_SLOT) {
+            value = interpret_var(symbols, value.as.object.data[slot]).value;
+        } else {
+            value = index_value(symbols, value, (Symbol_Value){.kind = SK_STRING, .as.string = path.data[chunk]}, loc);
+        }
     }
-    
-    return compute_indexing(symbols, metadata, symbol->value);
+
+    return compute_indexing(symbols, metadata, value);
 }
 
 Symbol_Value reduce_argument(Symbols symbols, Argument arg) {
+    // the arrays and objects would be copied all over again, down to the last item
+    if (arg.evaluated) {
+        switch (arg.kind) {
+            case AK_OBJECT: return (Symbol_Value){.kind = SK_OBJECT, .as.object = arg.as.object};
+            case AK_ARRAY: return (Symbol_Value){.kind = SK_ARRAY, .as.array = arg.as.array};
+            default: break;
+        }
+    }
+
+    // only what the indexes select is evaluated
+    if (arg.metadata.indexes.length > 0 && (arg.kind == AK_OBJECT || arg.kind == AK_ARRAY || arg.kind == AK_FUN_CALL)) {
+        Metadata metadata = arg.metadata;
+
+        arg.metadata = (Metadata){0};
+
+        return select_indexes(symbols, metadata, arg, current_declaration);
+    }
+
     switch (arg.kind) {
         case AK_NIL: return (Symbol_Value){.kind = SK_NIL};
         case AK_INTEGER: return (Symbol_Value){.kind = SK_INTEGER, .as.integer = arg.as.integer};
@@ -283,7 +470,10 @@ Symbol_Value reduce_argument(Symbols symbols, Argument arg) {
 }
 
 Array reduce_array(Symbols symbols, Array root) {
-    Array out = {0};
+    // only numbers in there, they are final already
+    if (root.packed != NULL) return root;
+
+    Array out = {.capacity = root.length, .data = value_alloc(symbols, root.length * sizeof(Argument))};
 
     for (size_t i = 0; i < root.length; ++i) {
         Argument arg = root.data[i];
@@ -294,17 +484,19 @@ Array reduce_array(Symbols symbols, Array root) {
             .loc = arg.loc,
             .kind = symbol_kind_to_argument_kind(value.kind),
             .as = symbol_data_type_to_argument_data_type(value.kind, value.as),
-            .metadata = {0}
+            .metadata = {0},
+            .evaluated = true
         };
 
-        array_append(&out, new_arg);
+        out.data[out.length++] = new_arg;
     }
 
     return out;
 }
 
 Object reduce_object(Symbols symbols, Object root) {
-    Object out = {0};
+    // same keys in the same order, so the key index still works
+    Object out = {.index = root.index, .capacity = root.length, .data = value_alloc(symbols, root.length * sizeof(Var))};
 
     for (size_t i = 0; i < root.length; ++i) {
         Var var = root.data[i];
@@ -313,7 +505,8 @@ Object reduce_object(Symbols symbols, Object root) {
             .loc = var.loc,
             .metadata = var.metadata,
             .kind = var_kind_to_argument_kind(var.kind),
-            .as = var_data_type_to_argument_data_type(var.kind, var.as)
+            .as = var_data_type_to_argument_data_type(var.kind, var.as),
+            .evaluated = var.evaluated
         };
 
         Symbol_Value value = reduce_argument(symbols, arg);
@@ -321,8 +514,9 @@ Object reduce_object(Symbols symbols, Object root) {
         var.kind = symbol_kind_to_var_kind(value.kind);
         var.metadata = (Metadata){0};
         var.as = symbol_data_type_to_var_data_type(value.kind, value.as);
+        var.evaluated = true;
 
-        array_append(&out, var);
+        out.data[out.length++] = var;
     }
 
     return out;
@@ -359,10 +553,12 @@ long __bultin_fun_call_sum_ai(Symbols symbols, Location loc, Fun_Call *fun_call)
         exit(1);
     }
 
+    if (array_packing(sym.as.array) == ARRAY_INTEGERS) return simd_sum_integers(sym.as.array.packed->integers, sym.as.array.length);
+
     long sum = 0;
 
     for (size_t i = 0; i < sym.as.array.length; ++i) {
-        Argument arg = sym.as.array.data[i];
+        Argument arg = array_at(sym.as.array, i);
         Symbol_Value value = reduce_argument(symbols, arg);
 
         if (value.kind != SK_INTEGER) {
@@ -413,15 +609,21 @@ double __bultin_fun_call_sum_af(Symbols symbols, Location loc, Fun_Call *fun_cal
         exit(1);
     }
 
-    double sum = 0;
+    if (array_packing(sym.as.array) == ARRAY_FLOATS) return simd_sum_floats(sym.as.array.packed->floats, sym.as.array.length);
 
-    for (size_t i = 0; i < sym.as.array.length; ++i) {
-        Argument arg = sym.as.array.data[i];
+    // Added in the same order as `simd_sum_floats`, so the same numbers give the same sum whether the array
+    // was packed or not (it's not when it's small or has a reference in it)
+    size_t length = sym.as.array.length, body = length - length % 4;
+    double lanes[4] = {0}, tail[3];
+
+    for (size_t i = 0; i < length; ++i) {
+        Argument arg = array_at(sym.as.array, i);
         Symbol_Value value = reduce_argument(symbols, arg);
+        double item;
 
         switch (value.kind) {
-            case SK_FLOAT: sum += value.as.floating.value; break;
-            case SK_INTEGER: sum += value.as.integer.value; break;
+            case SK_FLOAT: item = value.as.floating.value; break;
+            case SK_INTEGER: item = value.as.integer.value; break;
             default: {
                 fprintf(
                     stderr,
@@ -433,15 +635,27 @@ double __bultin_fun_call_sum_af(Symbols symbols, Location loc, Fun_Call *fun_cal
                 exit(1);
             }
         }
+
+        if (i < body) {
+            lanes[i % 4] += item;
+        } else {
+            tail[i - body] = item;
+        }
     }
 
+    double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+    for (size_t i = body; i < length; ++i) sum += tail[i - body];
+
     return sum;
 }
 
 Array __bultin_fun_call_concat_a(Symbols symbols, Location loc, Fun_Call *fun_call) {
     (void)loc;
 
-    Array result = {0};
+    struct { size_t length, capacity; Array *data; } arrays = {0};
+
+    array_reserve(&arrays, fun_call->arguments.length);
 
     for (size_t argument_index = 0; argument_index < fun_call->arguments.length; ++argument_index) {
         Argument arg_a = fun_call->arguments.data[argument_index];
@@ -457,18 +671,24 @@ Array __bultin_fun_call_concat_a(Symbols symbols, Location loc, Fun_Call *fun_ca
             exit(1);
         }
 
-
-        for (size_t i = 0; i < arr.as.array.length; ++i) array_append(&result, arr.as.array.data[i]);
+        array_append(&arrays, arr.as.array);
     }
 
+    // the items are shared with the arguments, not copied
+    Array result = rope_concat(arrays.data, arrays.length, symbols->values);
+
+    array_free(&arrays);
+
     return result;
 }
 
 String __bultin_fun_call_concat_s(Symbols symbols, Location loc, Fun_Call *fun_call) {
     (void)loc;
 
-    char *string = calloc(1, 1);
-    size_t string_size = 1;
+    struct { size_t length, capacity; Symbol_Value *data; } values = {0};
+    size_t total_size = 0;
+
+    array_reserve(&values, fun_call->arguments.length);
 
     for (size_t argument_index = 0; argument_index < fun_call->arguments.length; ++argument_index) {
         Argument arg = fun_call->arguments.data[argument_index];
@@ -484,15 +704,23 @@ String __bultin_fun_call_concat_s(Symbols symbols, Location loc, Fun_Call *fun_c
             exit(1);
         }
 
-        string_size += value.as.string.size;
+        total_size += value.as.string.size;
+
+        array_append(&values, value);
+    }
+
+    // in the arena of the values when there is one, like the other values (see `value_alloc`)
+    String_Builder builder = {.arena = symbols->values};
+
+    string_builder_reserve(&builder, total_size);
 
-        string = realloc(string, string_size);
-        strncat(string, value.as.string.value, value.as.string.size);
+    for (size_t i = 0; i < values.length; ++i) {
+        string_builder_append(&builder, values.data[i].as.string.value, values.data[i].as.string.size);
     }
 
-    string[string_size] = '\0';
+    array_free(&values);
 
-    return (String){.value = string, .size = string_size};
+    return (String){.value = builder.data, .size = builder.length};
 }
 
 String __bultin_fun_call_join_as(Symbols symbols, Location loc, Fun_Call *fun_call) {
@@ -506,9 +734,6 @@ String __bultin_fun_call_join_as(Symbols symbols, Location loc, Fun_Call *fun_ca
         exit(1);
     }
 
-    char *string = calloc(1, 1);
-    size_t string_size = 1;
-
     Argument arg1 = fun_call->arguments.data[0];
     Symbol_Value strings = reduce_argument(symbols, arg1);
 
@@ -535,8 +760,12 @@ String __bultin_fun_call_join_as(Symbols symbols, Location loc, Fun_Call *fun_ca
         exit(1);
     }
 
+    String glue = separator.kind == SK_STRING ? separator.as.string : (String){0};
+    size_t total_size = 0;
+
+    // the items are evaluated already, so they are only checked (and measured) here
     for (size_t i = 0; i < strings.as.array.length; ++i) {
-        Argument arg = strings.as.array.data[i];
+        Argument arg = array_at(strings.as.array, i);
         Symbol_Value value = reduce_argument(symbols, arg);
 
         if (value.kind != SK_STRING) {
@@ -549,25 +778,28 @@ String __bultin_fun_call_join_as(Symbols symbols, Location loc, Fun_Call *fun_ca
             exit(1);
         }
 
-        if (i > 0 && separator.kind == SK_STRING) {
-            string_size += separator.as.string.size;
+        if (i > 0) total_size += glue.size;
 
-            string = realloc(string, string_size);
-            strncat(string, separator.as.string.value, separator.as.string.size);
-        }
+        total_size += value.as.string.size;
+    }
 
-        string_size += value.as.string.size;
+    String_Builder builder = {.arena = symbols->values};
 
-        string = realloc(string, string_size);
-        strncat(string, value.as.string.value, value.as.string.size);
-    }
+    string_builder_reserve(&builder, total_size);
+
+    for (size_t i = 0; i < strings.as.array.length; ++i) {
+        String string = array_at(strings.as.array, i).as.string;
+
+        if (i > 0) string_builder_append(&builder, glue.value, glue.size);
 
-    string[string_size] = '\0';
+        string_builder_append(&builder, string.value, string.size);
+    }
 
-    return (String){.value = string, .size = string_size};
+    return (String){.value = builder.data, .size = builder.length};
 }
 
-Array __bultin_fun_call_keys(Symbols symbols, Location loc, Fun_Call *fun_call) {
+// What keys() gets the names from, the values of a literal object are not needed (see `can_skip_items`)
+static Object keys_object(Symbols symbols, Location loc, Fun_Call *fun_call) {
     if (fun_call->arguments.length != 1) {
         fprintf(
             stderr,
@@ -579,6 +811,9 @@ Array __bultin_fun_call_keys(Symbols symbols, Location loc, Fun_Call *fun_call)
     }
 
     Argument arg = fun_call->arguments.data[0];
+
+    if (arg.kind == AK_OBJECT && arg.metadata.indexes.length == 0 && can_skip_items(symbols, current_declaration)) return arg.as.object;
+
     Symbol_Value value = reduce_argument(symbols, arg);
 
     if (value.kind != SK_OBJECT) {
@@ -591,17 +826,24 @@ Array __bultin_fun_call_keys(Symbols symbols, Location loc, Fun_Call *fun_call)
         exit(1);
     }
 
-    Array result = {0};
+    return value.as.object;
+}
+
+Array __bultin_fun_call_keys(Symbols symbols, Location loc, Fun_Call *fun_call) {
+    Object object = keys_object(symbols, loc, fun_call);
+
+    Array result = {.capacity = object.length, .data = value_alloc(symbols, object.length * sizeof(Argument))};
 
-    for (size_t i = 0; i < value.as.object.length; ++i) {
-        Var var = value.as.object.data[i];
+    for (size_t i = 0; i < object.length; ++i) {
+        Var var = object.data[i];
         Argument argument = {
             .kind = AK_STRING,
             .loc = var.loc, // this is the wrong location
-            .as.string = var.name
+            .as.string = var.name,
+            .evaluated = true
         };
 
-        array_append(&result, argument);
+        result.data[result.length++] = argument;
     }
 
     return result;
@@ -714,128 +956,517 @@ long __bultin_fun_call_iota(Symbols symbols, Location loc, Fun_Call *fun_call) {
     return __builtin_iota_current_value++;
 }
 
-Symbol_Value eval_builtin_fun_call(Symbols symbols, Location loc, Fun_Call *fun_call) {
-    if (cmp_sized_strings(fun_call->name.value, fun_call->name.size, BUILTIN_FUN_SUM_I, strlen(BUILTIN_FUN_SUM_I))) {
-        return (Symbol_Value){
-            .kind = SK_INTEGER,
-            .as.integer.value = __bultin_fun_call_sum_i(symbols, loc, fun_call)
-        };
-    } else if (cmp_sized_strings(fun_call->name.value, fun_call->name.size, BUILTIN_FUN_SUM_F, strlen(BUILTIN_FUN_SUM_F))) {
-        return (Symbol_Value){
-            .kind = SK_FLOAT,
-            .as.floating.value = __bultin_fun_call_sum_f(symbols, loc, fun_call),
-        };
-    } else if (cmp_sized_strings(fun_call->name.value, fun_call->name.size, BUILTIN_FUN_LEN, strlen(BUILTIN_FUN_LEN))) {
-        return (Symbol_Value){
-            .kind = SK_INTEGER,
-            .as.integer.value = __bultin_fun_call_len(symbols, loc, fun_call),
-        };
-    } else if (cmp_sized_strings(fun_call->name.value, fun_call->name.size, BUILTIN_FUN_SUM_AI, strlen(BUILTIN_FUN_SUM_AI))) {
-        return (Symbol_Value){
-            .kind = SK_INTEGER,
-            .as.integer.value = __bultin_fun_call_sum_ai(symbols, loc, fun_call),
-        };
-    } else if (cmp_sized_strings(fun_call->name.value, fun_call->name.size, BUILTIN_FUN_SUM_AF, strlen(BUILTIN_FUN_SUM_AF))) {
-        return (Symbol_Value){
-            .kind = SK_FLOAT,
-            .as.floating.value = __bultin_fun_call_sum_af(symbols, loc, fun_call),
-        };
-    } else if (cmp_sized_strings(fun_call->name.value, fun_call->name.size, BUILTIN_FUN_CONCAT_A, strlen(BUILTIN_FUN_CONCAT_A))) {
-        return (Symbol_Value){
-            .kind = SK_ARRAY,
-            .as.array = __bultin_fun_call_concat_a(symbols, loc, fun_call),
-        };
-    } else if (cmp_sized_strings(fun_call->name.value, fun_call->name.size, BUILTIN_FUN_CONCAT_S, strlen(BUILTIN_FUN_CONCAT_S))) {
-        return (Symbol_Value){
-            .kind = SK_STRING,
-            .as.string = __bultin_fun_call_concat_s(symbols, loc, fun_call),
-        };
-    } else if (cmp_sized_strings(fun_call->name.value, fun_call->name.size, BUILTIN_FUN_JOIN_AS, strlen(BUILTIN_FUN_JOIN_AS))) {
-        return (Symbol_Value){
-            .kind = SK_STRING,
-            .as.string = __bultin_fun_call_join_as(symbols, loc, fun_call),
-        };
-    } else if (cmp_sized_strings(fun_call->name.value, fun_call->name.size, BUILTIN_FUN_KEYS, strlen(BUILTIN_FUN_KEYS))) {
-        return (Symbol_Value){
-            .kind = SK_ARRAY,
-            .as.array = __bultin_fun_call_keys(symbols, loc, fun_call),
-        };
-    } else if (cmp_sized_strings(fun_call->name.value, fun_call->name.size, BUILTIN_FUN_IOTA, strlen(BUILTIN_FUN_IOTA))) {
-        return (Symbol_Value){
-            .kind = SK_INTEGER,
-            .as.integer.value = __bultin_fun_call_iota(symbols, loc, fun_call),
+// Imports are evaluated by one thread at a time (their files are loaded at the same time, see import.h),
+// but the thread evaluating one can import again
+static pthread_mutex_t imports_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local size_t imports_depth = 0;
+
+// Every var of the imported file, as an object with the last declaration of each name (like the symbols table)
+static Object evaluate_import(Import *import) {
+    Interpreter *interpreter = interpreter_new(import->parser.vars, import->parser.length);
+
+    // the values go away with the file (see `imports_free`), nothing else allocates from its arena now
+    interpreter->values = &import->parser.arena;
+
+    // it counts from 0 in every file, no matter what imported it first
+    long iota = __builtin_iota_current_value;
+
+    __builtin_iota_current_value = 0;
+
+    for (size_t i = 0; i < interpreter->length; ++i) {
+        evaluate_declaration(interpreter, i);
+    }
+
+    __builtin_iota_current_value = iota;
+
+    Map *names = interpreter->names;
+    Object object = {
+        .length = names->length,
+        .capacity = names->length,
+        .data = value_alloc(interpreter, names->length * sizeof(Var)),
+    };
+
+    for (size_t i = 0; i < names->length; ++i) {
+        Declaration declaration = interpreter->declarations[*(size_t*)map_value_at(names, i)];
+
+        object.data[i] = (Var){
+            .kind = symbol_kind_to_var_kind(declaration.value.kind),
+            .name = declaration.var->name,
+            .loc = declaration.var->loc,
+            .as = symbol_data_type_to_var_data_type(declaration.value.kind, declaration.value.as),
+            .evaluated = true,
         };
-    } else {
+    }
+
+    // released with the parser of the file, like the indexes of its literal objects
+    if (object.length >= OBJECT_INDEX_MIN_LENGTH) {
+        object.index = arena_alloc(&import->parser.arena, sizeof(Object_Index));
+        *object.index = (Object_Index){0};
+        array_append(&import->parser.object_indexes, object.index);
+    }
+
+    import->interpreter = interpreter;
+
+    return object;
+}
+
+Object __bultin_fun_call_import(Symbols symbols, Location loc, Fun_Call *fun_call) {
+    if (fun_call->arguments.length != 1) {
         fprintf(
             stderr,
-            LOC_ERROR_FMT" Built-in function not found \033[1;35m%s\033[0m\n",
+            LOC_ERROR_FMT" Function "BUILTIN_FUN_IMPORT" expects 1 argument but received %ld\n",
             LOC_ERROR_ARG(loc),
-            fun_call->name.value
+            fun_call->arguments.length
         );
         exit(1);
     }
-}
 
-void print_symbol(Symbols *symbols, Symbol symbol, bool is_inside_array) {
-    if (!is_inside_array) {
-        printf("  %s = ", symbol.name.value);
-    }
+    Argument arg = fun_call->arguments.data[0];
+    Symbol_Value filename = reduce_argument(symbols, arg);
 
-    switch (symbol.value.kind) {
-        case SK_NIL: {
-            printf("nil");
-        } break;
-        case SK_STRING: {
-            printf("\"%s\"", symbol.value.as.string.value);
-        } break;
-        case SK_INTEGER: {
-            printf("%lu", symbol.value.as.integer.value);
-        } break;
-        case SK_FLOAT: {
-            printf("%lf", symbol.value.as.floating.value);
-        } break;
-        case SK_BOOLEAN: {
-            printf("%s", symbol.value.as.boolean.value == 1 ? "true" : "false");
-        } break;
-        case SK_ARRAY: {
-            printf("[");
-            for (size_t i = 0; i < symbol.value.as.array.length; ++i) {
-                Argument arg = symbol.value.as.array.data[i];
-                Symbol_Value reduced_value = reduce_argument(*symbols, arg);
+    if (filename.kind != SK_STRING) {
+        fprintf(
+            stderr,
+            LOC_ERROR_FMT" Function "BUILTIN_FUN_IMPORT" \033[1;35m%s\033[0m is not a string\n",
+            LOC_ERROR_ARG(arg.loc),
+            symbol_kind_name(filename.kind)
+        );
+        exit(1);
+    }
 
-                if (i > 0) printf(", ");
-                print_symbol(symbols, (Symbol){.value = reduced_value}, true);
-            }
-            printf("]");
-        } break;
-        case SK_OBJECT: {
-            printf("{");
-            for (size_t i = 0; i < symbol.value.as.object.length; ++i) {
-                Var var = symbol.value.as.object.data[i];
+    char *path = strndup(filename.as.string.value, filename.as.string.size);
+    Import *import = import_load(path, loc);
 
-                if (i > 0) printf(", ");
+    free(path);
 
-                Symbol symbol = interpret_var(*symbols, var);
+    if (imports_depth++ == 0) pthread_mutex_lock(&imports_lock);
 
-                printf("%s = ", var.name.value);
+    if (import->evaluating) {
+        fprintf(stderr, LOC_ERROR_FMT" cyclic import of \033[1;35m%s\033[0m\n", LOC_ERROR_ARG(loc), import->path);
+        exit(1);
+    }
 
-                print_symbol(symbols, symbol, true);
-            }
-            printf("}");
-        } break;
-        default: printf("unkonwn\n"); break;
+    if (!import->evaluated) {
+        import->evaluating = true;
+        import->value = evaluate_import(import);
+        import->evaluating = false;
+        import->evaluated = true;
     }
 
-    if (!is_inside_array) printf("\n");
+    if (--imports_depth == 0) pthread_mutex_unlock(&imports_lock);
+
+    return import->value;
 }
 
-Symbol interpret_var(Symbols symbols, Var var) {
-    Symbol symbol = {
-        .name = {
-            .value = var.name.value,
-            .size = var.name.size
-        },
-    };
+static Symbol_Value builtin_sum_i(Symbols symbols, Location loc, Fun_Call *fun_call) {
+    return (Symbol_Value){.kind = SK_INTEGER, .as.integer.value = __bultin_fun_call_sum_i(symbols, loc, fun_call)};
+}
+
+static Symbol_Value builtin_sum_f(Symbols symbols, Location loc, Fun_Call *fun_call) {
+    return (Symbol_Value){.kind = SK_FLOAT, .as.floating.value = __bultin_fun_call_sum_f(symbols, loc, fun_call)};
+}
+
+static Symbol_Value builtin_len(Symbols symbols, Location loc, Fun_Call *fun_call) {
+    return (Symbol_Value){.kind = SK_INTEGER, .as.integer.value = __bultin_fun_call_len(symbols, loc, fun_call)};
+}
+
+static Symbol_Value builtin_sum_ai(Symbols symbols, Location loc, Fun_Call *fun_call) {
+    return (Symbol_Value){.kind = SK_INTEGER, .as.integer.value = __bultin_fun_call_sum_ai(symbols, loc, fun_call)};
+}
+
+static Symbol_Value builtin_sum_af(Symbols symbols, Location loc, Fun_Call *fun_call) {
+    return (Symbol_Value){.kind = SK_FLOAT, .as.floating.value = __bultin_fun_call_sum_af(symbols, loc, fun_call)};
+}
+
+static Symbol_Value builtin_concat_a(Symbols symbols, Location loc, Fun_Call *fun_call) {
+    return (Symbol_Value){.kind = SK_ARRAY, .as.array = __bultin_fun_call_concat_a(symbols, loc, fun_call)};
+}
+
+static Symbol_Value builtin_concat_s(Symbols symbols, Location loc, Fun_Call *fun_call) {
+    return (Symbol_Value){.kind = SK_STRING, .as.string = __bultin_fun_call_concat_s(symbols, loc, fun_call)};
+}
+
+static Symbol_Value builtin_join_as(Symbols symbols, Location loc, Fun_Call *fun_call) {
+    return (Symbol_Value){.kind = SK_STRING, .as.string = __bultin_fun_call_join_as(symbols, loc, fun_call)};
+}
+
+static Symbol_Value builtin_keys(Symbols symbols, Location loc, Fun_Call *fun_call) {
+    return (Symbol_Value){.kind = SK_ARRAY, .as.array = __bultin_fun_call_keys(symbols, loc, fun_call)};
+}
+
+static Symbol_Value builtin_import(Symbols symbols, Location loc, Fun_Call *fun_call) {
+    return (Symbol_Value){.kind = SK_OBJECT, .as.object = __bultin_fun_call_import(symbols, loc, fun_call)};
+}
+
+static Symbol_Value builtin_iota(Symbols symbols, Location loc, Fun_Call *fun_call) {
+    return (Symbol_Value){.kind = SK_INTEGER, .as.integer.value = __bultin_fun_call_iota(symbols, loc, fun_call)};
+}
+
+// The arrays before the one with the item are evaluated (when they are not literals), not the ones after
+static Argument concat_a_at(Symbols symbols, Location loc, Fun_Call *fun_call, long index, Location index_loc) {
+    (void)loc;
+
+    size_t remaining = index;
+
+    if (index >= 0) {
+        for (size_t argument_index = 0; argument_index < fun_call->arguments.length; ++argument_index) {
+            Argument arg_a = fun_call->arguments.data[argument_index];
+            Array array = arg_a.as.array;
+
+            // the length of a literal is known without evaluating its items
+            if (arg_a.kind != AK_ARRAY || arg_a.metadata.indexes.length > 0) {
+                Symbol_Value arr = reduce_argument(symbols, arg_a);
+
+                if (arr.kind != SK_ARRAY) {
+                    fprintf(
+                        stderr,
+                        LOC_ERROR_FMT" Function "BUILTIN_FUN_CONCAT_A" \033[1;35m%s\033[0m is not an array\n",
+                        LOC_ERROR_ARG(arg_a.loc),
+                        symbol_kind_name(arr.kind)
+                    );
+                    exit(1);
+                }
+
+                array = arr.as.array;
+            }
+
+            if (remaining < array.length) return array_at(array, remaining);
+
+            remaining -= array.length;
+        }
+    }
+
+    check_index(index_loc, index, 0);
+
+    return (Argument){0};
+}
+
+static Argument keys_at(Symbols symbols, Location loc, Fun_Call *fun_call, long index, Location index_loc) {
+    Object object = keys_object(symbols, loc, fun_call);
+
+    check_index(index_loc, index, object.length);
+
+    Var var = object.data[index];
+
+    return (Argument){
+        .kind = AK_STRING,
+        .loc = var.loc, // this is the wrong location
+        .as.string = var.name,
+        .evaluated = true
+    };
+}
+
+// Sorted by name (see `find_builtin`)
+static const Builtin builtins[] = {
+    {BUILTIN_FUN_CONCAT_A, builtin_concat_a, NATIVE_ARRAY, concat_a_at},
+    {BUILTIN_FUN_CONCAT_S, builtin_concat_s, NATIVE_STRING, NULL},
+    {BUILTIN_FUN_IMPORT, builtin_import, NATIVE_OBJECT, NULL},
+    {BUILTIN_FUN_IOTA, builtin_iota, NATIVE_INTEGER, NULL},
+    {BUILTIN_FUN_JOIN_AS, builtin_join_as, NATIVE_STRING, NULL},
+    {BUILTIN_FUN_KEYS, builtin_keys, NATIVE_ARRAY, keys_at},
+    {BUILTIN_FUN_LEN, builtin_len, NATIVE_INTEGER, NULL},
+    {BUILTIN_FUN_SUM_AF, builtin_sum_af, NATIVE_FLOAT, NULL},
+    {BUILTIN_FUN_SUM_AI, builtin_sum_ai, NATIVE_INTEGER, NULL},
+    {BUILTIN_FUN_SUM_F, builtin_sum_f, NATIVE_FLOAT, NULL},
+    {BUILTIN_FUN_SUM_I, builtin_sum_i, NATIVE_INTEGER, NULL},
+};
+
+#define BUILTINS_LENGTH (sizeof(builtins) / sizeof(builtins[0]))
+
+static const Builtin *find_builtin(const char *name, size_t name_size) {
+    size_t low = 0, high = BUILTINS_LENGTH;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        const char *candidate = builtins[middle].name;
+        size_t candidate_size = strlen(candidate);
+        size_t common = candidate_size < name_size ? candidate_size : name_size;
+
+        int cmp = memcmp(candidate, name, common);
+
+        if (cmp == 0) cmp = candidate_size < name_size ? -1 : candidate_size > name_size;
+
+        if (cmp == 0) return &builtins[middle];
+
+        if (cmp < 0) low = middle + 1;
+        else high = middle;
+    }
+
+    return NULL;
+}
+
+bool interpreter_has_builtin(const char *name, size_t name_size) {
+    return find_builtin(name, name_size) != NULL;
+}
+
+// `container[index]` as the unevaluated item, when it can be picked without evaluating the container
+static bool pick_item(Symbols symbols, Argument container, Symbol_Value index, Location index_loc, Argument *item) {
+    // its own indexes come first
+    if (container.metadata.indexes.length > 0) return false;
+
+    switch (container.kind) {
+        case AK_ARRAY: {
+            if (index.kind != SK_INTEGER) return false;
+
+            check_index(index_loc, index.as.integer.value, container.as.array.length);
+
+            *item = array_at(container.as.array, index.as.integer.value);
+        } return true;
+        case AK_OBJECT: {
+            if (index.kind != SK_STRING) return false;
+
+            Var *var = object_get(container.as.object, index.as.string.value, index.as.string.size);
+
+            // not found, the evaluation reports it
+            if (var == NULL) return false;
+
+            *item = (Argument){
+                .loc = var->loc,
+                .metadata = var->metadata,
+                .kind = var_kind_to_argument_kind(var->kind),
+                .as = var_data_type_to_argument_data_type(var->kind, var->as),
+                .evaluated = var->evaluated
+            };
+        } return true;
+        case AK_FUN_CALL: {
+            const Builtin *builtin = container.as.fun_call->builtin;
+
+            if (index.kind != SK_INTEGER || builtin == NULL || builtin->at == NULL) return false;
+
+            *item = builtin->at(symbols, container.loc, container.as.fun_call, index.as.integer.value, index_loc);
+        } return true;
+        default: return false;
+    }
+}
+
+// `container[indexes...]`, each index picks an item of the unevaluated container while it can, so
+// `concat_a($/a, $/b)[0]` or `$/list[1]` (when nothing needed all of `list` yet) only evaluate what they
+// give. The container is evaluated whole at the first index that can't be pushed down this way.
+// The container is part of the declaration `owner`, its references are resolved from there, the ones of
+// the indexes from the current declaration.
+static Symbol_Value select_indexes(Symbols symbols, Metadata metadata, Argument container, size_t owner) {
+    if (!can_skip_items(symbols, owner)) return compute_indexing(symbols, metadata, reduce_argument(symbols, container));
+
+    size_t caller = current_declaration;
+    Argument current = container;
+    Symbol_Value value;
+
+    for (size_t i = 0; i < metadata.indexes.length; ++i) {
+        Argument arg = metadata.indexes.data[i];
+
+        current_declaration = caller;
+
+        Symbol_Value index = reduce_argument(symbols, arg);
+
+        current_declaration = owner;
+
+        if (pick_item(symbols, current, index, arg.loc, &current)) continue;
+
+        value = index_value(symbols, reduce_argument(symbols, current), index, arg.loc);
+
+        Metadata rest = {.indexes = {.length = metadata.indexes.length - i - 1, .data = metadata.indexes.data + i + 1}};
+
+        current_declaration = caller;
+
+        return compute_indexing(symbols, rest, value);
+    }
+
+    current_declaration = owner;
+    value = reduce_argument(symbols, current);
+    current_declaration = caller;
+
+    return value;
+}
+
+static Native_Kind symbol_kind_to_native_kind(Symbol_Kind kind) {
+    switch (kind) {
+        case SK_NIL: return NATIVE_NIL;
+        case SK_INTEGER: return NATIVE_INTEGER;
+        case SK_STRING: return NATIVE_STRING;
+        case SK_FLOAT: return NATIVE_FLOAT;
+        case SK_BOOLEAN: return NATIVE_BOOLEAN;
+        case SK_ARRAY: return NATIVE_ARRAY;
+        case SK_OBJECT: return NATIVE_OBJECT;
+        default: return NATIVE_ANY;
+    }
+}
+
+static bool native_accepts(Native_Kind expected, Native_Kind kind) {
+    return expected == NATIVE_ANY || expected == kind || (expected == NATIVE_FLOAT && kind == NATIVE_INTEGER);
+}
+
+static Native_Value symbol_value_to_native_value(Symbol_Value value, Native_Kind expected) {
+    switch (value.kind) {
+        case SK_NIL: return (Native_Value){.kind = NATIVE_NIL};
+        case SK_INTEGER: {
+            if (expected == NATIVE_FLOAT) return (Native_Value){.kind = NATIVE_FLOAT, .as.floating = value.as.integer.value};
+
+            return (Native_Value){.kind = NATIVE_INTEGER, .as.integer = value.as.integer.value};
+        }
+        case SK_STRING: return (Native_Value){.kind = NATIVE_STRING, .as.string = value.as.string};
+        case SK_FLOAT: return (Native_Value){.kind = NATIVE_FLOAT, .as.floating = value.as.floating.value};
+        case SK_BOOLEAN: return (Native_Value){.kind = NATIVE_BOOLEAN, .as.boolean = value.as.boolean.value};
+        case SK_ARRAY: return (Native_Value){.kind = NATIVE_ARRAY, .as.array = value.as.array};
+        case SK_OBJECT: return (Native_Value){.kind = NATIVE_OBJECT, .as.object = value.as.object};
+        default: assertf(false, "unreacheable");
+    }
+}
+
+static Symbol_Value native_value_to_symbol_value(Native_Value value) {
+    switch (value.kind) {
+        case NATIVE_NIL: return (Symbol_Value){.kind = SK_NIL};
+        case NATIVE_INTEGER: return (Symbol_Value){.kind = SK_INTEGER, .as.integer.value = value.as.integer};
+        case NATIVE_FLOAT: return (Symbol_Value){.kind = SK_FLOAT, .as.floating.value = value.as.floating};
+        case NATIVE_STRING: return (Symbol_Value){.kind = SK_STRING, .as.string = value.as.string};
+        case NATIVE_BOOLEAN: return (Symbol_Value){.kind = SK_BOOLEAN, .as.boolean.value = value.as.boolean};
+        case NATIVE_ARRAY: return (Symbol_Value){.kind = SK_ARRAY, .as.array = value.as.array};
+        case NATIVE_OBJECT: return (Symbol_Value){.kind = SK_OBJECT, .as.object = value.as.object};
+        default: assertf(false, "native function returned a value without kind");
+    }
+}
+
+// Most natives take a handful of arguments, so they don't need to be allocated
+#define NATIVE_INLINE_ARGUMENTS 8
+
+static Symbol_Value call_native(Symbols symbols, Location loc, Fun_Call *fun_call) {
+    const Native *native = fun_call->native;
+    size_t length = fun_call->arguments.length;
+
+    Native_Value inline_arguments[NATIVE_INLINE_ARGUMENTS];
+    Native_Value *arguments = length <= NATIVE_INLINE_ARGUMENTS ? inline_arguments : malloc(length * sizeof(Native_Value));
+
+    for (size_t i = 0; i < length; ++i) {
+        Argument argument = fun_call->arguments.data[i];
+        Native_Kind expected = native_argument_kind(native, i);
+        Symbol_Value value = reduce_argument(symbols, argument);
+
+        if (!fun_call->typed && !native_accepts(expected, symbol_kind_to_native_kind(value.kind))) {
+            fprintf(
+                stderr,
+                LOC_ERROR_FMT" Function \033[1;35m%.*s\033[0m expects %s as argument %ld but received \033[1;35m%s\033[0m\n",
+                LOC_ERROR_ARG(argument.loc),
+                (int)fun_call->name.size,
+                fun_call->name.value,
+                native_kind_name(expected),
+                i + 1,
+                symbol_kind_name(value.kind)
+            );
+            exit(1);
+        }
+
+        arguments[i] = symbol_value_to_native_value(value, expected);
+    }
+
+    Native_Value result = native->fun(native->context, arguments, length);
+
+    if (arguments != inline_arguments) free(arguments);
+
+    if (!native_accepts(native->result, result.kind) || result.kind == NATIVE_ANY) {
+        fprintf(
+            stderr,
+            LOC_ERROR_FMT" Function \033[1;35m%.*s\033[0m should return %s but returned \033[1;35m%s\033[0m\n",
+            LOC_ERROR_ARG(loc),
+            (int)fun_call->name.size,
+            fun_call->name.value,
+            native_kind_name(native->result),
+            native_kind_name(result.kind)
+        );
+        exit(1);
+    }
+
+    return native_value_to_symbol_value(result);
+}
+
+// The call was bound when the file was loaded (see `bind_fun_call`), so there is nothing left to look up
+Symbol_Value eval_builtin_fun_call(Symbols symbols, Location loc, Fun_Call *fun_call) {
+    if (fun_call->native != NULL) return call_native(symbols, loc, fun_call);
+
+    assertf(fun_call->builtin != NULL, "function call not bound");
+
+    return fun_call->builtin->fun(symbols, loc, fun_call);
+}
+
+void print_symbol(Symbols *symbols, Symbol symbol, bool is_inside_array) {
+    if (!is_inside_array) {
+        printf("  %.*s = ", (int)symbol.name.size, symbol.name.value);
+    }
+
+    switch (symbol.value.kind) {
+        case SK_NIL: {
+            printf("nil");
+        } break;
+        case SK_STRING: {
+            print_string(symbol.value.as.string);
+        } break;
+        case SK_INTEGER: {
+            printf("%lu", symbol.value.as.integer.value);
+        } break;
+        case SK_FLOAT: {
+            printf("%lf", symbol.value.as.floating.value);
+        } break;
+        case SK_BOOLEAN: {
+            printf("%s", symbol.value.as.boolean.value == 1 ? "true" : "false");
+        } break;
+        case SK_ARRAY: {
+            printf("[");
+            for (size_t i = 0; i < symbol.value.as.array.length; ++i) {
+                Argument arg = array_at(symbol.value.as.array, i);
+                Symbol_Value reduced_value = reduce_argument(*symbols, arg);
+
+                if (i > 0) printf(", ");
+                print_symbol(symbols, (Symbol){.value = reduced_value}, true);
+            }
+            printf("]");
+        } break;
+        case SK_OBJECT: {
+            printf("{");
+            for (size_t i = 0; i < symbol.value.as.object.length; ++i) {
+                Var var = symbol.value.as.object.data[i];
+
+                if (i > 0) printf(", ");
+
+                Symbol symbol = interpret_var(*symbols, var);
+
+                printf("%.*s = ", (int)var.name.size, var.name.value);
+
+                print_symbol(symbols, symbol, true);
+            }
+            printf("}");
+        } break;
+        default: printf("unkonwn\n"); break;
+    }
+
+    if (!is_inside_array) printf("\n");
+}
+
+Symbol interpret_var(Symbols symbols, Var var) {
+    Symbol symbol = {
+        .name = {
+            .value = var.name.value,
+            .size = var.name.size
+        },
+    };
+
+    if (var.evaluated) {
+        switch (var.kind) {
+            case VK_OBJECT: symbol.value = (Symbol_Value){.kind = SK_OBJECT, .as.object = var.as.object}; return symbol;
+            case VK_ARRAY: symbol.value = (Symbol_Value){.kind = SK_ARRAY, .as.array = var.as.array}; return symbol;
+            default: break;
+        }
+    }
+
+    // only what the indexes select is evaluated
+    if (var.metadata.indexes.length > 0 && (var.kind == VK_OBJECT || var.kind == VK_ARRAY || var.kind == VK_FUN_CALL)) {
+        Argument container = {
+            .kind = var_kind_to_argument_kind(var.kind),
+            .loc = var.loc,
+            .as = var_data_type_to_argument_data_type(var.kind, var.as),
+        };
+
+        symbol.value = select_indexes(symbols, var.metadata, container, current_declaration);
+
+        return symbol;
+    }
 
     switch (var.kind) {
         case VK_NIL: { symbol.value.kind = SK_NIL; } break;
@@ -872,29 +1503,477 @@ Symbol interpret_var(Symbols symbols, Var var) {
     return symbol;
 }
 
-void interpret(const Var *vars, size_t length) {
-    Symbols symbols = map_new();
+// Calls `path` for every reference and `fun_call` for every function call in the tree of a var
+typedef struct {
+    void (*path)(void *context, Path path);
+    void (*fun_call)(void *context, Fun_Call *fun_call, Location loc);
+    void *context;
+} Walker;
 
-    for (size_t i = 0; i < length; i++) {
-        Var var = vars[i];
+static void walk_argument(Walker *walker, const Argument *argument);
 
-        Symbol symbol = interpret_var(symbols, var);
+static void walk_metadata(Walker *walker, Metadata metadata) {
+    for (size_t i = 0; i < metadata.indexes.length; ++i) {
+        walk_argument(walker, &metadata.indexes.data[i]);
+    }
+}
 
-        map_set(symbols, symbol.name.value, &symbol, sizeof(Symbol));
+static void walk_fun_call(Walker *walker, Fun_Call *fun_call, Location loc) {
+    if (walker->fun_call != NULL) walker->fun_call(walker->context, fun_call, loc);
+
+    for (size_t i = 0; i < fun_call->arguments.length; ++i) {
+        walk_argument(walker, &fun_call->arguments.data[i]);
     }
+}
 
-    printf("Symbols table (%ld)\n", symbols->length);
-    for (size_t i = 0; i < MAP_BUCKET_SIZE; ++i) {
-        MapNode *node = symbols->nodes[i];
+static void walk_path(Walker *walker, Path path) {
+    if (walker->path != NULL) walker->path(walker->context, path);
+}
 
-        while (node != NULL) {
-            Symbol symbol = *(Symbol*)node->data;
+static void walk_var(Walker *walker, const Var *var) {
+    switch (var->kind) {
+        case VK_ARRAY: {
+            // the packed ones only have numbers
+            if (var->as.array.packed != NULL) break;
 
-            print_symbol(&symbols, symbol, false);
+            for (size_t i = 0; i < var->as.array.length; ++i) walk_argument(walker, &var->as.array.data[i]);
+        } break;
+        case VK_OBJECT: {
+            for (size_t i = 0; i < var->as.object.length; ++i) walk_var(walker, &var->as.object.data[i]);
+        } break;
+        case VK_PATH: walk_path(walker, var->as.path); break;
+        case VK_FUN_CALL: walk_fun_call(walker, var->as.fun_call, var->loc); break;
+        default: break;
+    }
+
+    walk_metadata(walker, var->metadata);
+}
+
+static void walk_argument(Walker *walker, const Argument *argument) {
+    switch (argument->kind) {
+        case AK_ARRAY: {
+            if (argument->as.array.packed != NULL) break;
+
+            for (size_t i = 0; i < argument->as.array.length; ++i) walk_argument(walker, &argument->as.array.data[i]);
+        } break;
+        case AK_OBJECT: {
+            for (size_t i = 0; i < argument->as.object.length; ++i) walk_var(walker, &argument->as.object.data[i]);
+        } break;
+        case AK_PATH: walk_path(walker, argument->as.path); break;
+        case AK_FUN_CALL: walk_fun_call(walker, argument->as.fun_call, argument->loc); break;
+        default: break;
+    }
 
-            node = node->next;
+    walk_metadata(walker, argument->metadata);
+}
+
+// What the argument evaluates to, when it can be known without evaluating it (NATIVE_ANY otherwise)
+static Native_Kind static_argument_kind(const Argument *argument) {
+    // indexing could give anything
+    if (argument->metadata.indexes.length > 0) return NATIVE_ANY;
+
+    switch (argument->kind) {
+        case AK_NIL: return NATIVE_NIL;
+        case AK_INTEGER: return NATIVE_INTEGER;
+        case AK_STRING: return NATIVE_STRING;
+        case AK_FLOAT: return NATIVE_FLOAT;
+        case AK_BOOLEAN: return NATIVE_BOOLEAN;
+        case AK_ARRAY: return NATIVE_ARRAY;
+        case AK_OBJECT: return NATIVE_OBJECT;
+        case AK_FUN_CALL: {
+            // the arguments are bound after the call itself, so it's looked up here
+            Fun_Call *fun_call = argument->as.fun_call;
+            const Builtin *builtin = find_builtin(fun_call->name.value, fun_call->name.size);
+
+            if (builtin != NULL) return builtin->result;
+
+            const Native *native = native_find(fun_call->name.value, fun_call->name.size);
+
+            return native != NULL ? native->result : NATIVE_ANY;
         }
+        default: return NATIVE_ANY;
+    }
+}
+
+// Checks the call against the signature of the native, returns false if it can never be right
+static bool check_native_call(const Native *native, Fun_Call *fun_call, Location loc) {
+    size_t length = fun_call->arguments.length;
+    size_t required = native->variadic ? native->arguments_length - 1 : native->arguments_length;
+
+    if (length < required || (!native->variadic && length > required)) {
+        fprintf(
+            stderr,
+            LOC_ERROR_FMT" Function \033[1;35m%.*s\033[0m expects %s%ld arguments but received %ld\n",
+            LOC_ERROR_ARG(loc),
+            (int)fun_call->name.size,
+            fun_call->name.value,
+            native->variadic ? "at least " : "",
+            required,
+            length
+        );
+        return false;
+    }
+
+    bool ok = true;
+
+    fun_call->typed = true;
+
+    for (size_t i = 0; i < length; ++i) {
+        Argument argument = fun_call->arguments.data[i];
+        Native_Kind expected = native_argument_kind(native, i);
+        Native_Kind kind = static_argument_kind(&argument);
+
+        if (expected == NATIVE_ANY) continue;
+
+        if (kind == NATIVE_ANY) {
+            // it'll be checked when it's evaluated
+            fun_call->typed = false;
+        } else if (!native_accepts(expected, kind)) {
+            fprintf(
+                stderr,
+                LOC_ERROR_FMT" Function \033[1;35m%.*s\033[0m expects %s as argument %ld but received \033[1;35m%s\033[0m\n",
+                LOC_ERROR_ARG(argument.loc),
+                (int)fun_call->name.size,
+                fun_call->name.value,
+                native_kind_name(expected),
+                i + 1,
+                native_kind_name(kind)
+            );
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+typedef struct {
+    Interpreter *interpreter;
+    // the declaration being bound
+    size_t index;
+    bool bound;
+} Binding;
+
+// Resolves the var of the path, and the keys of the chunks after it as far as the objects are literals
+static void bind_path(void *context, Path path) {
+    Binding *binding = context;
+    Path_Route *route = path.route;
+
+    route->declaration = find_declaration(binding->interpreter, path.data[0].value, path.data[0].size, binding->index);
+
+    const Var *var = route->declaration != NO_DECLARATION ? binding->interpreter->declarations[route->declaration].var : NULL;
+
+    for (size_t chunk = 1; chunk < path.length; ++chunk) {
+        route->slots[chunk - 1] = PATH_NO_SLOT;
+
+        // an indexed object could be anything once it's evaluated
+        if (var == NULL || var->kind != VK_OBJECT || var->evaluated || var->metadata.indexes.length > 0) {
+            var = NULL;
+            continue;
+        }
+
+        Var *item = object_get(var->as.object, path.data[chunk].value, path.data[chunk].size);
+
+        if (item != NULL) route->slots[chunk - 1] = item - var->as.object.data;
+
+        var = item;
+    }
+}
+
+static void bind_fun_call(void *context, Fun_Call *fun_call, Location loc) {
+    bool *bound = &((Binding*)context)->bound;
+
+    fun_call->builtin = find_builtin(fun_call->name.value, fun_call->name.size);
+
+    if (fun_call->builtin != NULL) return;
+
+    fun_call->native = native_find(fun_call->name.value, fun_call->name.size);
+
+    if (fun_call->native != NULL) {
+        if (!check_native_call(fun_call->native, fun_call, loc)) *bound = false;
+
+        return;
+    }
+
+    fprintf(
+        stderr,
+        LOC_ERROR_FMT" Built-in function not found \033[1;35m%.*s\033[0m\n",
+        LOC_ERROR_ARG(loc),
+        (int)fun_call->name.size,
+        fun_call->name.value
+    );
+    *bound = false;
+}
+
+static void find_iota_call(void *context, Fun_Call *fun_call, Location loc) {
+    (void)loc;
+
+    if (fun_call->builtin != NULL && fun_call->builtin->fun == builtin_iota) *(bool*)context = true;
+}
+
+Interpreter *interpreter_new(const Var *vars, size_t length) {
+    Interpreter *interpreter = calloc(1, sizeof(Interpreter));
+
+    interpreter->declarations = calloc(length, sizeof(Declaration));
+    interpreter->length = length;
+    interpreter->capacity = length;
+    interpreter->names = map_new(sizeof(size_t));
+
+    for (size_t i = 0; i < length; ++i) {
+        const Var *var = &vars[i];
+        size_t *last = map_get(interpreter->names, var->name.value, var->name.size);
+
+        interpreter->declarations[i] = (Declaration){
+            .var = var,
+            .previous = last != NULL ? *last : NO_DECLARATION,
+        };
+
+        map_set(interpreter->names, var->name.value, var->name.size, &i);
+    }
+
+    Binding binding = {.interpreter = interpreter, .bound = true};
+    Walker walker = {.path = bind_path, .fun_call = bind_fun_call, .context = &binding};
+
+    for (size_t i = 0; i < length; ++i) {
+        binding.index = i;
+        walk_var(&walker, &vars[i]);
+    }
+
+    if (!binding.bound) exit(1);
+
+    for (size_t i = 0; i < length; ++i) {
+        Walker iota_walker = {.fun_call = find_iota_call, .context = &interpreter->declarations[i].calls_iota};
+
+        walk_var(&iota_walker, &vars[i]);
+    }
+
+    return interpreter;
+}
+
+Interpreter *interpreter_stream_new(void) {
+    Interpreter *interpreter = calloc(1, sizeof(Interpreter));
+
+    interpreter->names = map_new(sizeof(size_t));
+
+    return interpreter;
+}
+
+void interpreter_stream_var(Interpreter *interpreter, const Var *var, Arena *values, bool keep) {
+    size_t index = interpreter->length;
+    size_t *last = map_get(interpreter->names, var->name.value, var->name.size);
+
+    Declaration declaration = {
+        .var = var,
+        .previous = last != NULL ? *last : NO_DECLARATION,
+    };
+
+    if (interpreter->length == interpreter->capacity) {
+        interpreter->capacity = interpreter->capacity == 0 ? 16 : 2 * interpreter->capacity;
+        interpreter->declarations = realloc(interpreter->declarations, interpreter->capacity * sizeof(Declaration));
+        assert(interpreter->declarations != NULL && "failed to allocate declarations");
+    }
+
+    interpreter->declarations[interpreter->length++] = declaration;
+
+    Binding binding = {.interpreter = interpreter, .index = index, .bound = true};
+    Walker walker = {.path = bind_path, .fun_call = bind_fun_call, .context = &binding};
+
+    walk_var(&walker, var);
+
+    if (!binding.bound) exit(1);
+
+    Walker iota_walker = {.fun_call = find_iota_call, .context = &interpreter->declarations[index].calls_iota};
+
+    walk_var(&iota_walker, var);
+
+    interpreter->values = values;
+
+    Symbol symbol = {
+        .name = {.value = var->name.value, .size = var->name.size},
+        .value = *evaluate_declaration(interpreter, index),
+    };
+
+    print_symbol(&interpreter, symbol, false);
+
+    interpreter->values = NULL;
+
+    // nothing can reference it after this, so it's forgotten (its name is only known while it's evaluated)
+    if (keep) {
+        map_set(interpreter->names, var->name.value, var->name.size, &index);
+    } else {
+        interpreter->length--;
+    }
+}
+
+bool interpreter_print(Interpreter *interpreter, const char *name, size_t name_size) {
+    Symbol_Value *value = lookup_symbol(interpreter, name, name_size);
+
+    if (value == NULL) return false;
+
+    Symbol symbol = {
+        .name = {.value = (char*)name, .size = name_size},
+        .value = *value,
+    };
+
+    print_symbol(&interpreter, symbol, false);
+
+    return true;
+}
+
+void interpreter_free(Interpreter *interpreter) {
+    map_free(interpreter->names);
+    free(interpreter->declarations);
+    free(interpreter);
+}
+
+typedef struct {
+    Interpreter *interpreter;
+    // the declaration being analysed
+    size_t index;
+    struct {
+        size_t length, capacity;
+        Dag_Edge *data;
+    } edges;
+    // how many times iota() is called by each declaration
+    size_t *iota_calls;
+} Analysis;
+
+static void analyse_path(void *context, Path path) {
+    Analysis *analysis = context;
+
+    // a reference that can't be resolved fails when it's evaluated
+    size_t index = path.route->declaration;
+
+    if (index != NO_DECLARATION) {
+        array_append(&analysis->edges, ((Dag_Edge){.from = index, .to = analysis->index}));
+    }
+}
+
+static void analyse_fun_call(void *context, Fun_Call *fun_call, Location loc) {
+    Analysis *analysis = context;
+    (void)loc;
+
+    // every call in the tree is evaluated exactly once per evaluation of the var
+    if (fun_call->builtin != NULL && fun_call->builtin->fun == builtin_iota) analysis->iota_calls[analysis->index]++;
+}
+
+typedef struct {
+    Interpreter *interpreter;
+    // what iota() returns first in each declaration, the same as when they are evaluated in order
+    long *iota_start;
+} Parallel_Evaluation;
+
+static void evaluate_task(void *context, size_t task) {
+    Parallel_Evaluation *evaluation = context;
+
+    __builtin_iota_current_value = evaluation->iota_start[task];
+
+    // everything it references is done already, so this never evaluates other declarations
+    evaluate_declaration(evaluation->interpreter, task);
+}
+
+// The declarations that don't reference each other (directly or not) are evaluated at the same time
+static void evaluate_in_parallel(Interpreter *interpreter, size_t threads) {
+    Analysis analysis = {
+        .interpreter = interpreter,
+        .iota_calls = calloc(interpreter->length, sizeof(size_t)),
+    };
+
+    Walker walker = {.path = analyse_path, .fun_call = analyse_fun_call, .context = &analysis};
+
+    for (size_t i = 0; i < interpreter->length; ++i) {
+        analysis.index = i;
+        walk_var(&walker, interpreter->declarations[i].var);
+    }
+
+    Parallel_Evaluation evaluation = {
+        .interpreter = interpreter,
+        .iota_start = calloc(interpreter->length, sizeof(long)),
+    };
+
+    long iota = __builtin_iota_current_value;
+
+    for (size_t i = 0; i < interpreter->length; ++i) {
+        evaluation.iota_start[i] = iota;
+        iota += analysis.iota_calls[i];
+    }
+
+    Dag dag = dag_new(interpreter->length, analysis.edges.data, analysis.edges.length);
+
+    dag_run(&dag, threads, evaluate_task, &evaluation);
+
+    __builtin_iota_current_value = iota;
+
+    dag_free(&dag);
+    array_free(&analysis.edges);
+    free(analysis.iota_calls);
+    free(evaluation.iota_start);
+}
+
+// EVALSET_THREADS=<n> overrides it (1 evaluates everything in order, on this thread)
+static size_t evaluation_threads(void) {
+    const char *forced = getenv("EVALSET_THREADS");
+
+    if (forced != NULL) {
+        long threads = strtol(forced, NULL, 10);
+
+        if (threads > 0) return threads;
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return cpus > 0 ? cpus : 1;
+}
+
+void interpreter_evaluate_all(Interpreter *interpreter) {
+    size_t threads = evaluation_threads();
+
+    if (threads > 1 && interpreter->length >= PARALLEL_MIN_VARS) {
+        evaluate_in_parallel(interpreter, threads);
+    } else {
+        for (size_t i = 0; i < interpreter->length; i++) {
+            evaluate_declaration(interpreter, i);
+        }
+    }
+}
+
+size_t interpreter_symbols_length(Interpreter *interpreter) {
+    return interpreter->names->length;
+}
+
+Var interpreter_symbol(Interpreter *interpreter, size_t i) {
+    Declaration declaration = interpreter->declarations[*(size_t*)map_value_at(interpreter->names, i)];
+
+    assert(declaration.state == DS_DONE && "the var was not evaluated");
+
+    return (Var){
+        .kind = symbol_kind_to_var_kind(declaration.value.kind),
+        .name = declaration.var->name,
+        .loc = declaration.var->loc,
+        .as = symbol_data_type_to_var_data_type(declaration.value.kind, declaration.value.as),
+        .evaluated = true,
+    };
+}
+
+void print_evaluated_var(Var var) {
+    assert(var.evaluated && var.metadata.indexes.length == 0 && "the var was not evaluated");
+
+    // nothing in it is evaluated again (nor looked up), so there is no need for an interpreter
+    Symbols symbols = NULL;
+
+    print_symbol(&symbols, interpret_var(symbols, var), false);
+}
+
+void interpret(const Var *vars, size_t length) {
+    Interpreter *interpreter = interpreter_new(vars, length);
+
+    interpreter_evaluate_all(interpreter);
+
+    size_t symbols_length = interpreter_symbols_length(interpreter);
+
+    printf("Symbols table (%ld)\n", symbols_length);
+    for (size_t i = 0; i < symbols_length; ++i) {
+        print_evaluated_var(interpreter_symbol(interpreter, i));
     }
 
-    map_free(symbols);
+    interpreter_free(interpreter);
 }
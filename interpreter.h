@@ -3,6 +3,33 @@
 
 #include "./parser.h"
 
+typedef struct Interpreter Interpreter;
+
+// Evaluates every var, in the order they are declared, and prints the symbols table
 void interpret(const Var *vars, size_t length);
 
+// Lazy evaluation: creating it only indexes the vars by name (the parser must outlive it).
+// A var is evaluated the first time it's asked for, with the vars it references, and kept for the next time.
+// Note that iota() counts in the order things get evaluated, so it may not match `interpret`.
+Interpreter *interpreter_new(const Var *vars, size_t length);
+// Prints the var like the symbols table does, returns false if there is no var with that name
+bool interpreter_print(Interpreter *interpreter, const char *name, size_t name_size);
+// Evaluates every var like `interpret` does, without printing them
+void interpreter_evaluate_all(Interpreter *interpreter);
+// The symbols table, once everything is evaluated: the last declaration of each name, in the order the names first
+// appear, as a var with its value (see `Var.evaluated`)
+size_t interpreter_symbols_length(Interpreter *interpreter);
+Var interpreter_symbol(Interpreter *interpreter, size_t i);
+// Prints an evaluated var like the symbols table does
+void print_evaluated_var(Var var);
+// Streaming: the vars are given one at a time, in the order they are declared, and each one is evaluated and
+// printed (like the symbols table does) right away. Its values are allocated from `values`, so that arena (and
+// the var) must live as long as the var is referenced.
+// Only the vars given with `keep` can be referenced by the ones that come after, the others (with their arena)
+// can be released as soon as it returns.
+Interpreter *interpreter_stream_new(void);
+void interpreter_stream_var(Interpreter *interpreter, const Var *var, Arena *values, bool keep);
+void interpreter_free(Interpreter *interpreter);
+bool interpreter_has_builtin(const char *name, size_t name_size);
+
 #endif // !INTERPRETER_H_
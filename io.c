@@ -4,41 +4,102 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-size_t read_from_file(const char *filename, char **content) {
-    FILE *fptr = fopen(filename, "r");
+#define READ_CHUNK_SIZE (64 * 1024)
 
-    if (fptr == NULL) {
-        fprintf(stderr, "could not open file %s due to: %s\n", filename, strerror(errno));
-        exit(1);
-    }
+// Pipes and special files have no size up front, so it grows until the end
+static File_Content read_from_stream(const char *filename, int fd) {
+    File_Content content = {0};
+    size_t capacity = READ_CHUNK_SIZE;
 
-    fseek(fptr, 0, SEEK_END);
-    const size_t stream_size = ftell(fptr);
-    rewind(fptr);
+    content.data = malloc(capacity);
 
-    if (content != NULL) {
-        *content = malloc((stream_size + 1) * sizeof(char));
-
-        if (*content == NULL) {
-            fprintf(stderr, "could not open allocate memory enough: %s\n", strerror(errno));
+    for (;;) {
+        if (content.data == NULL) {
+            fprintf(stderr, "could not allocate enough memory: %s\n", strerror(errno));
             exit(1);
         }
 
-        const size_t read_size = fread(*content, 1, stream_size, fptr);
+        // one more for the '\0'
+        if (content.size + 1 >= capacity) {
+            capacity *= 2;
+            content.data = realloc(content.data, capacity);
+            continue;
+        }
 
-        if (read_size != stream_size) {
+        ssize_t read_size = read(fd, content.data + content.size, capacity - content.size - 1);
+
+        if (read_size < 0 && errno == EINTR) continue;
+
+        if (read_size < 0) {
             fprintf(stderr, "could not read file %s due to: %s\n", filename, strerror(errno));
-            fclose(fptr);
             exit(1);
         }
 
-        (*content)[stream_size] = '\0';
-    } else {
-        fprintf(stderr, "could not write file content because 'content' variable is null\n");
+        if (read_size == 0) break;
+
+        content.size += read_size;
+    }
+
+    content.data[content.size] = '\0';
+
+    return content;
+}
+
+// The mapping is one byte bigger than the file, so there is always a '\0' after the content: the rest of
+// the last page of the file is zeroed by the kernel and, when the file fills it, the anonymous page
+// reserved below it is.
+static File_Content map_file(const char *filename, int fd, size_t size) {
+    long page_size = sysconf(_SC_PAGESIZE);
+    size_t mapped_size = (size + 1 + page_size - 1) / page_size * page_size;
+
+    char *data = mmap(NULL, mapped_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (data == MAP_FAILED || mmap(data, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        fprintf(stderr, "could not map file %s due to: %s\n", filename, strerror(errno));
+        exit(1);
+    }
+
+    // it's read once, from the start to the end
+    (void)madvise(data, size, MADV_SEQUENTIAL);
+
+    return (File_Content){.data = data, .size = size, .mapped_size = mapped_size};
+}
+
+File_Content read_from_file(const char *filename) {
+    int fd = open(filename, O_RDONLY);
+
+    if (fd < 0) {
+        fprintf(stderr, "could not open file %s due to: %s\n", filename, strerror(errno));
+        exit(1);
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) < 0) {
+        fprintf(stderr, "could not open file %s due to: %s\n", filename, strerror(errno));
+        exit(1);
     }
 
-    fclose(fptr);
+    File_Content content = S_ISREG(info.st_mode) && info.st_size > 0
+        ? map_file(filename, fd, info.st_size)
+        : read_from_stream(filename, fd);
+
+    close(fd);
+
+    return content;
+}
+
+void file_content_free(File_Content *content) {
+    if (content->mapped_size > 0) {
+        munmap(content->data, content->mapped_size);
+    } else {
+        free(content->data);
+    }
 
-    return stream_size;
+    *content = (File_Content){0};
 }
@@ -3,6 +3,19 @@
 
 #include <stddef.h>
 
-size_t read_from_file(const char *filename, char **content);
+// The content of a file, always followed by a '\0' (not counted in the size).
+// Regular files are mapped in memory (read-only), so the tokens point right into the page cache.
+// Anything else (pipes, special files) is read into a buffer.
+typedef struct {
+    char *data;
+    size_t size;
+    // the size of the mapping, 0 when it was read into a buffer
+    size_t mapped_size;
+} File_Content;
+
+// Exits when the file can't be read
+File_Content read_from_file(const char *filename);
+// The tokens, names and strings point into the content, so it goes after the parser and the lexer
+void file_content_free(File_Content *content);
 
 #endif // IO_H_
@@ -5,46 +5,39 @@
 #include <stdlib.h>
 #include <string.h>
 #include "./utils.h"
+#include "./simd.h"
 
 // This do-while(0) is a hack to avoid some issues. https://www.geeksforgeeks.org/multiline-macros-in-c/
 // As the article says, we can wrap with parenthesis, but we're using -pedantic and
 // "ISO C forbids braced-groups within expressions".
 #define throw_error(call, lexer) \
     do { \
-        error(); \
+        error(lexer); \
         call(lexer); \
     } while (0); \
 
-// I don't think we need to put this inside the lexer
-// I'm not sure if would make sense, so, I prefer to create this in a static segment and "private"
-// So, we can just return the pointer to it and that's it.
-static Token *tokens_head = NULL;
-static Token *tokens_tail = NULL;
-
-static unsigned int errors = 0;
-
 static char chr(Lexer *lexer);
 
 void print_tokens(Token *head) {
     return;
     Token *curr = head;
 
-    while (curr != NULL) {
+    while (true) {
         const char *kind_name = token_kind_name(curr->kind);
 
         switch (curr->kind) {
             case TK_NEWLINE:
-                printf("NOTE %s:%d:%d: \\n (%s)\n", curr->loc.filename, curr->loc.line, curr->loc.col, kind_name);
+                printf("NOTE %s:%d:%d: \\n (%s)\n", LOC_ERROR_ARG(curr->loc), kind_name);
                 break;
             case TK_EOF:
-                printf("NOTE %s:%d:%d: <eof> (%s)\n", curr->loc.filename, curr->loc.line, curr->loc.col, kind_name);
-                break;
+                printf("NOTE %s:%d:%d: <eof> (%s)\n", LOC_ERROR_ARG(curr->loc), kind_name);
+                return;
             default:
-                printf("NOTE %s:%d:%d: %.*s (%s)\n", curr->loc.filename, curr->loc.line, curr->loc.col, (int)curr->content_size, curr->content, kind_name);
+                printf("NOTE %s:%d:%d: %.*s (%s)\n", LOC_ERROR_ARG(curr->loc), (int)curr->content_size, curr->content, kind_name);
                 break;
         }
 
-        curr = curr->next;
+        curr++;
     }
 }
 
@@ -165,36 +158,46 @@ const char *token_kind_name(Token_Kind kind) {
     }
 }
 
-static void error(void) {
-    ++errors;
+static void error(Lexer *lexer) {
+    ++lexer->errors;
 
     #if DEBUG
-    print_tokens(tokens_head);
+    print_tokens(lexer->tokens.data);
     #endif
 }
 
+// Where the cursor is right now
+static Location cursor_loc(Lexer *lexer) {
+    return (Location){.offset = lexer->base + lexer->cursor, .file = lexer->file};
+}
+
+// Where the token we are capturing started
+static Location bot_loc(Lexer *lexer) {
+    return (Location){.offset = lexer->base + lexer->bot, .file = lexer->file};
+}
+
 static void unrecognized_char_error(Lexer *lexer) {
-    fprintf(stderr, "%s:%d:%d: \033[1;31merror\033[0m unrecognized character '%c'\n", lexer->loc.filename, lexer->loc.line, lexer->loc.col, chr(lexer));
+    fprintf(stderr, LOC_ERROR_FMT" unrecognized character '%c'\n", LOC_ERROR_ARG(cursor_loc(lexer)), chr(lexer));
 }
 
 static void unexpected_char_error(Lexer *lexer) {
-    fprintf(stderr, "%s:%d:%d: \033[1;31merror\033[0m unexpected character '%c'\n", lexer->loc.filename, lexer->loc.line, lexer->loc.col, chr(lexer));
+    fprintf(stderr, LOC_ERROR_FMT" unexpected character '%c'\n", LOC_ERROR_ARG(cursor_loc(lexer)), chr(lexer));
 }
 
 static void invalid_number_error(Lexer *lexer) {
-    fprintf(stderr, "%s:%d:%d: \033[1;31merror\033[0m invalid number '%.*s'\n", lexer->loc.filename, lexer->loc.line, lexer->loc.col, lexer->cursor - lexer->bot, lexer->content + lexer->bot);
+    fprintf(stderr, LOC_ERROR_FMT" invalid number '%.*s'\n", LOC_ERROR_ARG(cursor_loc(lexer)), lexer->cursor - lexer->bot, lexer->content + lexer->bot);
 }
 
 static void invalid_path_chunk_error(Lexer *lexer) {
-    fprintf(stderr, "%s:%d:%d: \033[1;31merror\033[0m invalid path chunk '%.*s'\n", lexer->loc.filename, lexer->loc.line, lexer->loc.col, lexer->cursor - lexer->bot, lexer->content + lexer->bot);
+    fprintf(stderr, LOC_ERROR_FMT" invalid path chunk '%.*s'\n", LOC_ERROR_ARG(cursor_loc(lexer)), lexer->cursor - lexer->bot, lexer->content + lexer->bot);
 }
 
 static void unterminated_string_error(Lexer *lexer) {
-    fprintf(stderr, "%s:%d:%d: \033[1;31merror\033[0m unterminated string\n", lexer->loc.filename, lexer->bline, lexer->bcol);
+    fprintf(stderr, LOC_ERROR_FMT" unterminated string\n", LOC_ERROR_ARG(bot_loc(lexer)));
 }
 
 static void invalid_escape_character_error(Lexer *lexer) {
-    fprintf(stderr, "%s:%d:%d: \033[1;31merror\033[0m invalid escape character '\\%c'\n", lexer->loc.filename, lexer->loc.line, lexer->loc.col, lexer->content[lexer->cursor + 1]);
+    fprintf(stderr, LOC_ERROR_FMT" invalid escape character '\\%c'\n", LOC_ERROR_ARG(cursor_loc(lexer)), lexer->content[lexer->cursor + 1]);
 }
 
 // For now, reading the file here is OK.
@@ -202,22 +205,22 @@ static void invalid_escape_character_error(Lexer *lexer) {
 // multiple imports
 Lexer create_lexer(const char *filename, char *data, size_t data_size) {
     Lexer lexer = (Lexer){
-        .loc = (Location){
-            .filename = filename,
-            .col = 1,
-            .line = 1,
-        },
-        .bline = 1,
-        .bcol = 1,
+        .file = loc_register_file(filename, data, data_size),
         .cursor = 0,
         .bot = 0,
         .content_size = data_size,
-        .content = data
+        .content = data,
+        .tokens = {0},
+        .errors = 0,
     };
 
     return lexer;
 }
 
+Lexer create_stream_lexer(const char *filename) {
+    return (Lexer){.file = loc_register_stream(filename)};
+}
+
 // Get the current char without moving the cursor
 static char chr(Lexer *lexer) {
     if (lexer->cursor < lexer->content_size) {
@@ -238,25 +241,25 @@ static char pchr(Lexer *lexer) {
 // Advance the cursor to the next char
 static char nchr(Lexer *lexer) {
     if (lexer->cursor < lexer->content_size) {
-        char c = chr(lexer);
-
         ++lexer->cursor;
 
-        if (c == '\n') {
-            lexer->loc.col = 1;
-            ++lexer->loc.line;
-        } else {
-            ++lexer->loc.col;
-        }
-
         return chr(lexer);
-    } else if (lexer->cursor < lexer->content_size) {
-        ++lexer->cursor;
     }
 
     return '\0';
 }
 
+// Advance the cursor over `count` chars at once.
+// This is what allows the vectorized scans to skip a whole run of chars in one step.
+static void skip_chars(Lexer *lexer, size_t count) {
+    lexer->cursor += count;
+}
+
+// Jump straight to the next char that can end (or escape something inside) a string literal
+static void skip_string_body(Lexer *lexer) {
+    skip_chars(lexer, simd_find_string_special(lexer->content + lexer->cursor, lexer->content_size - lexer->cursor));
+}
+
 static Token_Kind get_kind_keyword(Token *token, Token_Kind fallback) {
     if (cmp_sized_strings(token->content, token->content_size, "true", 4)) return TK_TRUE;
 
@@ -268,30 +271,19 @@ static Token_Kind get_kind_keyword(Token *token, Token_Kind fallback) {
 }
 
 static void save_token(Lexer *lexer, Token_Kind kind) {
-    Token *token = calloc(1, sizeof(Token));
-   
-    token->loc.filename = lexer->loc.filename;
-    token->loc.col = lexer->bcol;
-    token->loc.line = lexer->bline;
-
-    token->content = lexer->content + lexer->bot;
-    token->content_size = lexer->cursor - lexer->bot;
-
-    token->next = NULL;
+    Token token = {
+        .loc = bot_loc(lexer),
+        .content = lexer->content + lexer->bot,
+        .content_size = lexer->cursor - lexer->bot,
+    };
 
     if (kind == TK_SYM) {
-        token->kind = get_kind_keyword(token, TK_SYM);
+        token.kind = get_kind_keyword(&token, TK_SYM);
     } else {
-        token->kind = kind;
+        token.kind = kind;
     }
 
-    if (tokens_head == NULL) {
-        tokens_head = token;
-        tokens_tail = token;
-    } else {
-        tokens_tail->next = token;
-        tokens_tail = tokens_tail->next;
-    }
+    array_append(&lexer->tokens, token);
 }
 
 static bool is_alpha(char c) {
@@ -306,10 +298,6 @@ static bool is_digit(char c) {
     return c >= '0' && c <= '9';
 }
 
-static bool is_whitespace(char c) {
-    return c == ' ' || c == '\t' || c == '\r';
-}
-
 // lexing
 static void lex_symbol(Lexer *lexer) {
     while (is_symbol(chr(lexer))) nchr(lexer);
@@ -376,7 +364,7 @@ static void lex_path_chunk(Lexer *lexer) {
 }
 
 static void lex_comment(Lexer *lexer) {
-    while (chr(lexer) != '\n') nchr(lexer);
+    skip_chars(lexer, simd_find_newline(lexer->content + lexer->cursor, lexer->content_size - lexer->cursor));
 
     nchr(lexer);
     // maybe I'll save it to implement some kind of "prettier" later
@@ -389,6 +377,8 @@ static void lex_string(Lexer *lexer) {
 
     bool lexing = true;
 
+    skip_string_body(lexer);
+
     while (chr(lexer) != '"' && lexing) {
         if (chr(lexer) == '\\') {
             switch (pchr(lexer)) {
@@ -406,12 +396,14 @@ static void lex_string(Lexer *lexer) {
                     throw_error(invalid_escape_character_error, lexer);
                     break;
             }
-        } else if (chr(lexer) == '\n') {
+        } else if (chr(lexer) == '\n' || lexer->cursor >= lexer->content_size) {
             throw_error(unterminated_string_error, lexer);
             break;
         }
 
         nchr(lexer);
+
+        if (lexing) skip_string_body(lexer);
     }
 
     nchr(lexer);
@@ -469,15 +461,18 @@ static void lex_eof(Lexer *lexer) {
 Token *lex(Lexer *lexer) {
     if (lexer->content == NULL) return NULL;
 
+    // A low guess from the file size (a token with the whitespaces around it is rarely under 16 bytes) saves
+    // the first reallocations on big files, and `array_append` doubles it if it's not enough. Reserving for the
+    // worst case would take several times the size of the file up front.
+    array_reserve(&lexer->tokens, lexer->content_size / 16 + 1);
+
     bool lexing = true;
 
     while (lexing) {
         // trim whitespaces
-        while (is_whitespace(chr(lexer))) nchr(lexer);
+        skip_chars(lexer, simd_skip_whitespace(lexer->content + lexer->cursor, lexer->content_size - lexer->cursor));
 
         lexer->bot = lexer->cursor;
-        lexer->bline = lexer->loc.line;
-        lexer->bcol = lexer->loc.col;
 
         switch (chr(lexer)) {
             case '-': lex_number(lexer); break;
@@ -515,21 +510,13 @@ Token *lex(Lexer *lexer) {
         }
     }
 
-    if (errors == 0) return tokens_head;
+    if (lexer->errors == 0) return lexer->tokens.data;
 
     return NULL;
 }
 
 void lexer_free(Lexer *lexer) {
-    free(lexer->content);
-
-    Token *curr = tokens_head;
+    loc_forget_file(lexer->file);
 
-    while (curr != NULL) {
-        Token *next = curr->next;
-
-        free(curr);
-
-        curr = next;
-    }
+    array_free(&lexer->tokens);
 }
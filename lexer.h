@@ -52,9 +52,7 @@ typedef enum {
     TK_PATH_CHUNK
 } Token_Kind;
 
-typedef struct Token Token;
-
-struct Token {
+typedef struct {
     // The content of the token is not a null-terminated string, it's a pointer to where it starts
     // and the size of it, so, we can grab later the real value without wasting memory to every new
     // token we found. We just use the same file data to all of the tokens without allocating memory.
@@ -63,12 +61,17 @@ struct Token {
 
     Token_Kind kind;
 
-    // It's important to have the `filename` in the token struct because, maybe later, we implement
-    // some kind of "import" stuff, then we need to know in which file we encountered an error, warning, etc.
+    // It's important to know the file of the token because of the imports (see import.h),
+    // we need to know in which file we encountered an error, warning, etc.
     Location loc;
+} Token;
 
-    Token *next;
-};
+// All the tokens of a file live in a single contiguous block, in the same order they appear in the file.
+// The last one is always a TK_EOF, so the parser can just walk it until it finds the end.
+typedef struct {
+    size_t length, capacity;
+    Token *data;
+} Tokens;
 
 typedef struct {
     // This is the reading cursor. It moves over the file during the lexing.
@@ -76,29 +79,35 @@ typedef struct {
     // This is where a token starts (Beginning of the token). So, everytime we check for
     // some sort of token, we update it to the current cursor value, to indicate that this
     // is the beginning of the token we are capturing right now.
+    // It's also the location of the token, lines and columns are only computed when an error is shown.
     unsigned int bot;
-    // This is the line where the token begins. So, if, for some reason, the token need
-    // multiple lines, we keep track in which line it begins.
-    unsigned int bline;
-    // As in the `bline`, this keep track of the color in which the tokens started to be captured
-    // So, if it's a symbol like "root", it'll have the column of the first symbol character 
-    unsigned int bcol;
 
     char *content;
     unsigned long content_size;
+    // Where `content` starts in the file. It's only not 0 when the file is lexed a piece at a time (see stream.h),
+    // the cursor is still relative to `content`, but the locations are not.
+    unsigned int base;
 
-    // Here, we keep track of the current line and column in which the cursor are
-    // So, if we need to show an erro in the current cursor position we know the exact position in the file
-    Location loc;
+    // The id of this file in the source table (see loc.h)
+    unsigned short file;
+
+    // Everything the lexer produces lives here (and not in some global), so each file gets its own lexer
+    // and many of them can run at the same time, even on different threads.
+    Tokens tokens;
+    unsigned int errors;
 } Lexer;
 
 void print_tokens(Token *head);
 const char *token_kind_name(Token_Kind kind);
 const char *token_kind_value(Token_Kind kind);
 
+// The data is not copied nor released by the lexer (see `read_from_file`), it must outlive the lexer.
 Lexer create_lexer(const char *filename, char *data, size_t data_size);
+// For a file that comes in pieces (see stream.h), the content is set (and moved along) by the caller.
+Lexer create_stream_lexer(const char *filename);
 // This function returns a pointer if the lexing was done successfully and NULL if not
 // indicating that some errors was displayed to the user.
+// The tokens are owned by the lexer, so they are valid until `lexer_free` is called.
 Token *lex(Lexer *lexer);
 void lexer_free(Lexer *lexer);
 
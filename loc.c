@@ -0,0 +1,304 @@
+#include "./loc.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "./simd.h"
+#include "./utils.h"
+
+#define MAX_FILES 65535
+
+typedef struct {
+    size_t length, capacity;
+    // offset of the first char of each line, so it's sorted and lines[0] is always 0
+    unsigned int *data;
+} Line_Starts;
+
+// The lines of a part of a streamed file (see `loc_stream_piece`)
+typedef struct {
+    unsigned int start, end;
+    // the number of lines before it
+    size_t first_line;
+    Line_Starts lines;
+} Line_Piece;
+
+typedef struct {
+    const char *filename;
+    const char *content;
+    size_t content_size;
+
+    Line_Starts lines;
+
+    // read a piece at a time, `content_size` is how much was read so far
+    bool stream;
+    // For a streamed file `lines` only has the ones that are not in a piece yet (the first one starts where the
+    // last piece ends), and there are `first_line` lines before them. The pieces are sorted by where they start.
+    size_t first_line;
+    struct {
+        size_t length, capacity;
+        Line_Piece *data;
+    } pieces;
+} Source;
+
+static struct {
+    size_t length, capacity;
+    Source *data;
+} sources = {0};
+
+// The ids of the forgotten files, they are given to the next files registered
+static struct {
+    size_t length, capacity;
+    unsigned short *data;
+} free_files = {0};
+
+static pthread_mutex_t sources_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned short register_source(Source source) {
+    pthread_mutex_lock(&sources_lock);
+
+    unsigned short file;
+
+    if (free_files.length > 0) {
+        file = free_files.data[--free_files.length];
+        sources.data[file] = source;
+    } else {
+        if (sources.length >= MAX_FILES) {
+            fprintf(stderr, "could not load %s: too many files (the limit is %d)\n", source.filename, MAX_FILES);
+            exit(1);
+        }
+
+        array_append(&sources, source);
+
+        file = sources.length - 1;
+    }
+
+    pthread_mutex_unlock(&sources_lock);
+
+    return file;
+}
+
+unsigned short loc_register_file(const char *filename, const char *content, size_t content_size) {
+    // the offsets of the locations have 32 bits
+    if (content_size > UINT_MAX) {
+        fprintf(stderr, "could not load %s: files bigger than 4 GB are not supported\n", filename);
+        exit(1);
+    }
+
+    return register_source((Source){
+        .filename = filename,
+        .content = content,
+        .content_size = content_size,
+        .lines = {0},
+    });
+}
+
+unsigned short loc_register_stream(const char *filename) {
+    Source source = {.filename = filename, .stream = true};
+
+    array_append(&source.lines, 0);
+
+    return register_source(source);
+}
+
+void loc_stream_chunk(unsigned short file, const char *chunk, size_t size) {
+    pthread_mutex_lock(&sources_lock);
+
+    assert(file < sources.length && sources.data[file].stream && "not a streamed file");
+
+    Source *source = &sources.data[file];
+    size_t offset = 0;
+
+    // the same limit as `loc_register_file`
+    if (source->content_size + size > UINT_MAX) {
+        fprintf(stderr, "could not load %s: files bigger than 4 GB are not supported\n", source->filename);
+        exit(1);
+    }
+
+    while (offset < size) {
+        offset += simd_find_newline(chunk + offset, size - offset) + 1;
+
+        if (offset <= size) array_append(&source->lines, source->content_size + offset);
+    }
+
+    source->content_size += size;
+
+    pthread_mutex_unlock(&sources_lock);
+}
+
+void loc_stream_piece(unsigned short file, size_t size) {
+    pthread_mutex_lock(&sources_lock);
+
+    assert(file < sources.length && sources.data[file].stream && "not a streamed file");
+
+    Source *source = &sources.data[file];
+    Line_Starts *lines = &source->lines;
+    Line_Piece piece = {
+        .start = lines->data[0],
+        .end = lines->data[0] + size,
+        .first_line = source->first_line,
+    };
+    size_t count = 0;
+
+    while (count < lines->length && lines->data[count] < piece.end) ++count;
+
+    // the last one is empty when the file ends with a '\n'
+    if (count > 0) {
+        array_reserve(&piece.lines, count);
+        memcpy(piece.lines.data, lines->data, count * sizeof(unsigned int));
+        piece.lines.length = count;
+    }
+
+    array_append(&source->pieces, piece);
+
+    lines->length -= count;
+    memmove(lines->data, lines->data + count, lines->length * sizeof(unsigned int));
+
+    // the pieces end with a '\n', so the next line starts right there (it's only missing at the end of the file)
+    if (lines->length == 0) array_append(lines, piece.end);
+
+    source->first_line += count;
+
+    pthread_mutex_unlock(&sources_lock);
+}
+
+void loc_stream_forget_piece(unsigned short file, size_t start) {
+    pthread_mutex_lock(&sources_lock);
+
+    assert(file < sources.length && sources.data[file].stream && "not a streamed file");
+
+    Source *source = &sources.data[file];
+    size_t i = source->pieces.length;
+
+    // it's usually the last one
+    while (i > 0 && source->pieces.data[i - 1].start != start) --i;
+
+    assert(i > 0 && "there is no piece there");
+
+    array_free(&source->pieces.data[i - 1].lines);
+
+    source->pieces.length--;
+    memmove(&source->pieces.data[i - 1], &source->pieces.data[i], (source->pieces.length - (i - 1)) * sizeof(Line_Piece));
+
+    pthread_mutex_unlock(&sources_lock);
+}
+
+void loc_forget_file(unsigned short file) {
+    pthread_mutex_lock(&sources_lock);
+
+    assert(file < sources.length && "invalid file id");
+
+    Source *source = &sources.data[file];
+
+    for (size_t i = 0; i < source->pieces.length; ++i) array_free(&source->pieces.data[i].lines);
+
+    array_free(&source->pieces);
+    source->first_line = 0;
+    source->stream = false;
+    source->content = NULL;
+    source->content_size = 0;
+    array_free(&source->lines);
+
+    array_append(&free_files, file);
+
+    pthread_mutex_unlock(&sources_lock);
+}
+
+const char *loc_filename(Location loc) {
+    pthread_mutex_lock(&sources_lock);
+
+    assert(loc.file < sources.length && "invalid file id");
+
+    const char *filename = sources.data[loc.file].filename;
+
+    pthread_mutex_unlock(&sources_lock);
+
+    return filename;
+}
+
+static void build_line_starts(Source *source) {
+    array_reserve(&source->lines, simd_count_newlines(source->content, source->content_size) + 1);
+
+    size_t offset = 0;
+
+    array_append(&source->lines, 0);
+
+    while (offset < source->content_size) {
+        offset += simd_find_newline(source->content + offset, source->content_size - offset) + 1;
+
+        if (offset <= source->content_size) array_append(&source->lines, offset);
+    }
+}
+
+// `lines` are the lines from `first_line` on, and the offset is in one of them
+static Line_Col find_line(const Line_Starts *lines, size_t first_line, unsigned int offset) {
+    // the last line that starts at or before the offset
+    size_t low = 0, high = lines->length;
+
+    while (high - low > 1) {
+        size_t middle = low + (high - low) / 2;
+
+        if (lines->data[middle] <= offset) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    return (Line_Col){
+        .line = first_line + low + 1,
+        .col = offset - lines->data[low] + 1,
+    };
+}
+
+// The piece of a streamed file the offset is in
+static const Line_Piece *find_piece(const Source *source, unsigned int offset) {
+    size_t low = 0, high = source->pieces.length;
+
+    while (high - low > 1) {
+        size_t middle = low + (high - low) / 2;
+
+        if (source->pieces.data[middle].start <= offset) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    assert(
+        low < source->pieces.length && source->pieces.data[low].start <= offset && offset < source->pieces.data[low].end &&
+        "the lines of that part of the file were already released"
+    );
+
+    return &source->pieces.data[low];
+}
+
+Line_Col loc_line_col(Location loc) {
+    pthread_mutex_lock(&sources_lock);
+
+    assert(loc.file < sources.length && "invalid file id");
+
+    Source *source = &sources.data[loc.file];
+    Line_Col line_col;
+
+    if (source->stream && loc.offset < source->lines.data[0]) {
+        const Line_Piece *piece = find_piece(source, loc.offset);
+
+        line_col = find_line(&piece->lines, piece->first_line, loc.offset);
+    } else {
+        if (source->lines.length == 0) {
+            assert(source->content != NULL && "the file content was already released");
+
+            build_line_starts(source);
+        }
+
+        line_col = find_line(&source->lines, source->first_line, loc.offset);
+    }
+
+    pthread_mutex_unlock(&sources_lock);
+
+    return line_col;
+}
@@ -1,12 +1,43 @@
 #ifndef _LOC_H_
 #define _LOC_H_
 
+#include <stddef.h>
+
 #define LOC_ERROR_FMT "%s:%d:%d: \033[1;31merror\033[0m"
-#define LOC_ERROR_ARG(loc) loc.filename, loc.line, loc.col
+#define LOC_ERROR_ARG(loc) loc_filename(loc), loc_line_col(loc).line, loc_line_col(loc).col
 
+// A location is just where something starts in its file. The line and column are not tracked while
+// lexing, they are computed from the offset (see `loc_line_col`) only when we need to show them,
+// which is almost always to report an error.
 typedef struct {
-    unsigned int line, col;
-    const char *filename;
+    // In bytes, from the beginning of the file
+    unsigned int offset;
+    // The id given by `loc_register_file`
+    unsigned short file;
 } Location;
 
+typedef struct {
+    unsigned int line, col;
+} Line_Col;
+
+// Every file we read needs to be registered, so a location can be turned back into filename:line:col.
+// The content is not copied, so it must stay alive until `loc_forget_file` is called. After that its id is
+// given to the next file registered, so the locations of a forgotten file must not be used anymore.
+// Files bigger than 4 GB (UINT_MAX) are rejected, the offsets wouldn't fit.
+// It's safe to call these functions from many threads at the same time.
+unsigned short loc_register_file(const char *filename, const char *content, size_t content_size);
+void loc_forget_file(unsigned short file);
+// A file that is read a piece at a time (see stream.h) has no content to keep, instead each chunk is given
+// to `loc_stream_chunk` as it's read, in order, and only where its lines start is kept.
+// Then `loc_stream_piece` makes the next `size` bytes (a batch of whole lines) a piece, whose lines can be
+// released with `loc_stream_forget_piece` (by where it starts) once nothing of it is used anymore.
+unsigned short loc_register_stream(const char *filename);
+void loc_stream_chunk(unsigned short file, const char *chunk, size_t size);
+void loc_stream_piece(unsigned short file, size_t size);
+void loc_stream_forget_piece(unsigned short file, size_t start);
+
+const char *loc_filename(Location loc);
+// The first time it's called for a file, it builds the table with where each line starts in it.
+Line_Col loc_line_col(Location loc);
+
 #endif // !_LOC_H_
@@ -4,124 +4,169 @@
 #include <string.h>
 #include <stdio.h>
 
-size_t hash_key(char *key) {
-    unsigned long hash = 5381;
+#define MAP_INITIAL_SLOTS 16
+// grow when more than 7/8 of the slots are taken
+#define MAP_MAX_LOAD(capacity) ((capacity) - (capacity) / 8)
 
-    int i = 0;
+// FNV-1a with a final mix, so the lower bits (the ones used to find a slot) depend on the whole key
+static uint64_t hash_key(const char *key, size_t key_size) {
+    uint64_t hash = 14695981039346656037ULL;
 
-    while (key[i] != '\0') {
-        hash = ((hash << 5) + hash) + (int)(key[i] - '0');
-        i++;
+    for (size_t i = 0; i < key_size; ++i) {
+        hash ^= (unsigned char)key[i];
+        hash *= 1099511628211ULL;
     }
 
-    return hash % MAP_BUCKET_SIZE;
+    hash ^= hash >> 32;
+    hash *= 0xd6e8feb86659fd93ULL;
+    hash ^= hash >> 32;
+
+    return hash;
 }
 
-void realloc_node_data(MapNode *node, size_t data_size) {
-    if (data_size == 0 || node->data == NULL) return;
+static void *checked_realloc(void *ptr, size_t size) {
+    void *output = realloc(ptr, size);
 
-    if (node->data != NULL) {
-        node->data = realloc(node->data, data_size);
+    if (output == NULL) {
+        fprintf(stderr, "Error: Failed to reallocate memory\n");
+        exit(EXIT_FAILURE);
+    }
 
-        if (node->data == NULL) {
-            fprintf(stderr, "Error: Failed to reallocate memory\n");
-            exit(EXIT_FAILURE);
-        }
-    } else {
-        node->data = malloc(data_size);
+    return output;
+}
 
-        if (node->data == NULL) {
-            fprintf(stderr, "Error: Failed to allocate memory\n");
-            exit(EXIT_FAILURE);
-        }
-    }
+// How far the slot is from where the hash wanted it to be
+static size_t probe_distance(Map *map, uint32_t hash, size_t slot) {
+    size_t mask = map->slots_capacity - 1;
+
+    return (slot + map->slots_capacity - (hash & mask)) & mask;
 }
 
-MapNode *new_node(Map* map, char *key, void *data, size_t data_size) {
-    MapNode *node = calloc(1, sizeof(MapNode));
+// Robin hood: while probing, whoever is closer to its home slot gives the place to the one that is farther
+static void insert_slot(Map *map, MapSlot slot) {
+    size_t mask = map->slots_capacity - 1;
+    size_t index = slot.hash & mask;
+    size_t distance = 0;
 
-    node->key = key; // Should I copy?
+    while (true) {
+        MapSlot *current = &map->slots[index];
 
-    node->next = NULL;
+        if (current->entry == 0) {
+            *current = slot;
+            return;
+        }
 
-    if (data != NULL) {
-        node->data = malloc(data_size);
+        size_t current_distance = probe_distance(map, current->hash, index);
 
-        memcpy(node->data, data, data_size);
+        if (current_distance < distance) {
+            MapSlot tmp = *current;
+            *current = slot;
+            slot = tmp;
+            distance = current_distance;
+        }
+
+        index = (index + 1) & mask;
+        ++distance;
     }
+}
 
-    map->length++;
+static void grow_slots(Map *map) {
+    size_t capacity = map->slots_capacity == 0 ? MAP_INITIAL_SLOTS : map->slots_capacity * 2;
 
-    return node;
-}
+    free(map->slots);
+
+    map->slots = calloc(capacity, sizeof(MapSlot));
+    map->slots_capacity = capacity;
 
-Map *map_new(void) {
-    return calloc(1, sizeof(Map));
+    if (map->slots == NULL) {
+        fprintf(stderr, "Error: Failed to allocate memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // the hashes are cached in the entries, so there is no need to hash the keys again
+    for (size_t i = 0; i < map->length; ++i) {
+        insert_slot(map, (MapSlot){.entry = i + 1, .hash = (uint32_t)map->entries[i].hash});
+    }
 }
 
-void map_set(Map *map, char *key, void *data, size_t data_size) {
-    size_t index = hash_key(key);
+static MapSlot *find_slot(Map *map, uint64_t hash, const char *key, size_t key_size) {
+    if (map->slots_capacity == 0) return NULL;
 
-    MapNode *current = map->nodes[index];
+    size_t mask = map->slots_capacity - 1;
+    uint32_t short_hash = (uint32_t)hash;
+    size_t index = short_hash & mask;
 
-    if (current == NULL) {
-        map->nodes[index] = new_node(map, key, data, data_size);
+    for (size_t distance = 0; ; ++distance) {
+        MapSlot *slot = &map->slots[index];
 
-        return;
-    }
+        // if we are already farther than the one sitting here, the key would have taken its place
+        if (slot->entry == 0 || probe_distance(map, slot->hash, index) < distance) return NULL;
 
-    while (current != NULL) {
-        if (cmp_sized_strings(current->key, strlen(current->key), key, strlen(key))) {
-            realloc_node_data(current, data_size);
-            memcpy(current->data, data, data_size);
+        if (slot->hash == short_hash) {
+            MapEntry *entry = &map->entries[slot->entry - 1];
 
-            return;
+            if (entry->hash == hash && cmp_sized_strings(entry->key, entry->key_size, key, key_size)) return slot;
         }
 
-        if (current->next == NULL) break;
-
-        current = current->next;
+        index = (index + 1) & mask;
     }
-
-    current->next = new_node(map, key, data, data_size);
 }
 
-void map_set_i(Map *map, char *key, int i) {
-    map_set(map, key, &i, sizeof(int));
-}
+Map *map_new(size_t value_size) {
+    Map *map = calloc(1, sizeof(Map));
+
+    map->value_size = value_size;
 
-void map_set_s(Map *map, char *key, char *s) {
-    map_set(map, key, s, strlen(s) + 1);
+    return map;
 }
 
-void *map_get(Map *map, char *key) {
-    size_t index = hash_key(key);
+void map_set(Map *map, const char *key, size_t key_size, const void *data) {
+    uint64_t hash = hash_key(key, key_size);
 
-    MapNode *current = map->nodes[index];
+    MapSlot *slot = find_slot(map, hash, key, key_size);
 
-    while (current != NULL && !cmp_sized_strings(current->key, strlen(current->key), key, strlen(key))) {
-        current = current->next;
+    if (slot != NULL) {
+        memcpy(map->values + (slot->entry - 1) * map->value_size, data, map->value_size);
+
+        return;
     }
 
-    return current != NULL ? current->data : NULL;
-}
+    if (map->length >= map->entries_capacity) {
+        map->entries_capacity = map->entries_capacity == 0 ? MAP_INITIAL_SLOTS : map->entries_capacity * 2;
+        map->entries = checked_realloc(map->entries, map->entries_capacity * sizeof(MapEntry));
+        map->values = checked_realloc(map->values, map->entries_capacity * map->value_size);
+    }
 
-void map_free(Map *map) {
-    for (size_t i = 0; i < MAP_BUCKET_SIZE; i++) {
-        MapNode *current = map->nodes[i];
+    map->entries[map->length] = (MapEntry){
+        .hash = hash,
+        .key = key,
+        .key_size = key_size,
+    };
 
-        if (current != NULL) {
-            while (current != NULL) {
-                MapNode *next = current->next;
+    memcpy(map->values + map->length * map->value_size, data, map->value_size);
 
-                // free(current->key); // Should I Free?
-                free(current->data);
-                free(current);
+    map->length++;
 
-                current = next;
-            }
-        }
+    if (map->length > MAP_MAX_LOAD(map->slots_capacity)) {
+        grow_slots(map);
+    } else {
+        insert_slot(map, (MapSlot){.entry = map->length, .hash = (uint32_t)hash});
     }
+}
+
+void *map_get(Map *map, const char *key, size_t key_size) {
+    MapSlot *slot = find_slot(map, hash_key(key, key_size), key, key_size);
 
+    return slot != NULL ? map->values + (slot->entry - 1) * map->value_size : NULL;
+}
+
+void *map_value_at(Map *map, size_t i) {
+    return map->values + i * map->value_size;
+}
+
+void map_free(Map *map) {
+    free(map->entries);
+    free(map->values);
+    free(map->slots);
     free(map);
 }
@@ -4,29 +4,47 @@
 #include <stdint.h>
 #include <stddef.h>
 
-#define MAP_BUCKET_SIZE 512
+// Open addressing (robin hood) hash table from sized strings to fixed size values.
+//
+// The entries are kept in insertion order in a dense array, with the values stored inline, right next
+// to each other. The table itself is just a small index to them, with a piece of the hash cached in
+// every slot, so most of the probing never touches the entries (or compares keys).
 
-typedef struct MapNode MapNode;
+typedef struct {
+    uint64_t hash;
+    // The key is not copied (and not null-terminated), so it needs to live as long as the map
+    const char *key;
+    size_t key_size;
+} MapEntry;
 
-struct MapNode {
-    void *data;
-    size_t data_size;
+typedef struct {
+    // 0 means empty, otherwise it's the index of the entry + 1
+    uint32_t entry;
+    // the lower bits of the entry hash, enough to find its home slot and to skip most of the mismatches
+    uint32_t hash;
+} MapSlot;
 
-    char *key;
+typedef struct {
+    // in insertion order
+    MapEntry *entries;
+    // `value_size` bytes for each entry, in the same order
+    unsigned char *values;
+    size_t length, entries_capacity;
 
-    MapNode *next;
-};
+    MapSlot *slots;
+    // always a power of 2
+    size_t slots_capacity;
 
-typedef struct {
-    MapNode* nodes[MAP_BUCKET_SIZE]; // TODO: increase memory space as needed
-    size_t length;
+    size_t value_size;
 } Map;
 
-Map *map_new(void);
-void map_set(Map *map, char *key, void *data, size_t data_size);
-void map_set_i(Map *map, char *key, int i);
-void map_set_s(Map *map, char *key, char *s);
-void *map_get(Map *map, char *key);
+Map *map_new(size_t value_size);
+// The value is copied into the map. If the key is already there, its value is replaced.
+void map_set(Map *map, const char *key, size_t key_size, const void *data);
+// The pointer is only valid until the next `map_set`, because the values may move when the map grows
+void *map_get(Map *map, const char *key, size_t key_size);
+// The i-th entry inserted (0 <= i < length), so the map can be walked in insertion order
+void *map_value_at(Map *map, size_t i);
 void map_free(Map *map);
 
 #endif // CL_MAP_H_
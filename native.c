@@ -0,0 +1,65 @@
+#include <stdlib.h>
+#include <string.h>
+#include "./native.h"
+#include "./interpreter.h"
+#include "./map.h"
+
+// name -> Native*, so the natives never move (the calls point to them)
+static Map *natives = NULL;
+
+bool native_register(Native native) {
+    size_t name_size = strlen(native.name);
+
+    if (native.variadic && native.arguments_length == 0) return false;
+
+    if (interpreter_has_builtin(native.name, name_size) || native_find(native.name, name_size) != NULL) return false;
+
+    if (natives == NULL) natives = map_new(sizeof(Native*));
+
+    Native *copy = malloc(sizeof(Native));
+
+    *copy = native;
+
+    map_set(natives, native.name, name_size, &copy);
+
+    return true;
+}
+
+const Native *native_find(const char *name, size_t name_size) {
+    if (natives == NULL) return NULL;
+
+    Native **native = map_get(natives, name, name_size);
+
+    return native != NULL ? *native : NULL;
+}
+
+Native_Kind native_argument_kind(const Native *native, size_t i) {
+    if (native->variadic && i + 1 >= native->arguments_length) return native->arguments[native->arguments_length - 1];
+
+    return native->arguments[i];
+}
+
+const char *native_kind_name(Native_Kind kind) {
+    switch (kind) {
+        case NATIVE_ANY: return "any";
+        case NATIVE_NIL: return "nil";
+        case NATIVE_INTEGER: return "integer";
+        case NATIVE_FLOAT: return "float";
+        case NATIVE_STRING: return "string";
+        case NATIVE_BOOLEAN: return "boolean";
+        case NATIVE_ARRAY: return "array";
+        case NATIVE_OBJECT: return "object";
+        default: return "unknown";
+    }
+}
+
+void native_unregister_all(void) {
+    if (natives == NULL) return;
+
+    for (size_t i = 0; i < natives->length; ++i) {
+        free(*(Native**)map_value_at(natives, i));
+    }
+
+    map_free(natives);
+    natives = NULL;
+}
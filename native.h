@@ -0,0 +1,67 @@
+#ifndef NATIVE_H_
+#define NATIVE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "./parser.h"
+
+// Functions written in C by the host, callable from the files like the builtins.
+//
+// The signature is declared when the function is registered, and the calls are checked against it when
+// the file is loaded: the number of arguments always, and the kind of every argument whose kind is
+// known without evaluating it (literals and calls of functions with a declared result). The rest are
+// checked when evaluated. Either way, the callback only receives arguments of the declared kinds.
+
+typedef enum {
+    NATIVE_ANY = 0, // no check, the argument comes as it is
+    NATIVE_NIL,
+    NATIVE_INTEGER,
+    NATIVE_FLOAT, // integers are accepted too, they come converted
+    NATIVE_STRING,
+    NATIVE_BOOLEAN,
+    NATIVE_ARRAY,
+    NATIVE_OBJECT,
+} Native_Kind;
+
+typedef struct {
+    Native_Kind kind; // never NATIVE_ANY
+    union {
+        long integer;
+        double floating;
+        String string;
+        bool boolean;
+        // the items are evaluated already (see `Argument.evaluated`), read them with `array_at`
+        Array array;
+        Object object;
+    } as;
+} Native_Value;
+
+// Called for every evaluation of a call, maybe from many threads at once (see EVALSET_THREADS).
+// The calls in items an index doesn't select are not evaluated at all, like `f()` in `concat_a([f()], $/a)[1]`.
+// It has to return a value of the declared kind. Strings, arrays and objects that are returned must
+// live as long as the interpreter (arrays and objects made of evaluated values only).
+typedef Native_Value (*Native_Fun)(void *context, const Native_Value *arguments, size_t length);
+
+struct Native {
+    // not copied, so it must live as long as the native is registered
+    const char *name;
+    Native_Kind result;
+    // the kind of each argument, with `variadic` the last one can be repeated (or be missing)
+    const Native_Kind *arguments;
+    size_t arguments_length;
+    bool variadic;
+    Native_Fun fun;
+    void *context;
+};
+
+// Must be done before loading the files that use it. The natives are copied, not the name nor the argument kinds.
+// Returns false if the name is taken by a builtin or another native (or if it's variadic without argument kinds).
+bool native_register(Native native);
+// The registered native named `name`, or NULL
+const Native *native_find(const char *name, size_t name_size);
+// The kind expected for the i-th argument
+Native_Kind native_argument_kind(const Native *native, size_t i);
+const char *native_kind_name(Native_Kind kind);
+void native_unregister_all(void);
+
+#endif // !NATIVE_H_
@@ -0,0 +1,121 @@
+#include "./number.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Every integer up to 2^53 can be represented exactly by a double
+#define MAX_EXACT_MANTISSA (1ULL << 53)
+// And so every power of ten up to 10^22
+#define MAX_EXACT_POW10 22
+
+#define FALLBACK_BUFFER_SIZE 128
+
+static const double pow10_table[MAX_EXACT_POW10 + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+Number_Status parse_integer(const char *data, size_t size, long *out) {
+    size_t i = 0;
+    bool negative = false;
+
+    if (i < size && data[i] == '-') {
+        negative = true;
+        ++i;
+    }
+
+    if (i == size) return NUMBER_INVALID;
+
+    // accumulate as unsigned, so LONG_MIN (which has no positive counterpart) still fits
+    unsigned long limit = negative ? (unsigned long)LONG_MAX + 1 : (unsigned long)LONG_MAX;
+    unsigned long value = 0;
+
+    for (; i < size; ++i) {
+        if (!is_digit(data[i])) return NUMBER_INVALID;
+
+        unsigned long digit = data[i] - '0';
+
+        if (value > (limit - digit) / 10) return NUMBER_OUT_OF_RANGE;
+
+        value = value * 10 + digit;
+    }
+
+    *out = negative ? (long)(0 - value) : (long)value;
+
+    return NUMBER_OK;
+}
+
+// When the number has only a few significant digits it can be computed exactly as `mantissa / 10^n`,
+// because both are exact doubles and the division is correctly rounded (Clinger's fast path).
+// That's almost every float found in a config file. Anything else goes to strtod.
+Number_Status parse_float(const char *data, size_t size, double *out) {
+    size_t i = 0;
+    bool negative = false;
+
+    if (i < size && data[i] == '-') {
+        negative = true;
+        ++i;
+    }
+
+    uint64_t mantissa = 0;
+    size_t integer_digits = 0, fraction_digits = 0;
+    bool fast = true;
+
+    for (; i < size && is_digit(data[i]); ++i, ++integer_digits) {
+        if (mantissa > (MAX_EXACT_MANTISSA - 9) / 10) fast = false;
+        else mantissa = mantissa * 10 + (data[i] - '0');
+    }
+
+    if (i == size || data[i] != '.') return NUMBER_INVALID;
+
+    ++i;
+
+    for (; i < size && is_digit(data[i]); ++i, ++fraction_digits) {
+        if (mantissa > (MAX_EXACT_MANTISSA - 9) / 10) fast = false;
+        else mantissa = mantissa * 10 + (data[i] - '0');
+    }
+
+    if (i != size || integer_digits == 0 || fraction_digits == 0) return NUMBER_INVALID;
+
+    if (fast && fraction_digits <= MAX_EXACT_POW10) {
+        double value = (double)mantissa / pow10_table[fraction_digits];
+
+        *out = negative ? -value : value;
+
+        return NUMBER_OK;
+    }
+
+    // strtod needs a null-terminated string, so the span is copied to the stack. The ones that
+    // don't fit are read in place: the span is already validated and the char right after it
+    // can't continue a number (the lexer makes sure of that), so strtod stops right at its end.
+    char buffer[FALLBACK_BUFFER_SIZE];
+    const char *number = data;
+
+    if (size < FALLBACK_BUFFER_SIZE) {
+        memcpy(buffer, data, size);
+        buffer[size] = '\0';
+        number = buffer;
+    }
+
+    char *end;
+
+    errno = 0;
+
+    double value = strtod(number, &end);
+
+    if (end != number + size) return NUMBER_INVALID;
+    if (errno == ERANGE && isinf(value)) return NUMBER_OUT_OF_RANGE;
+
+    *out = value;
+
+    return NUMBER_OK;
+}
@@ -0,0 +1,20 @@
+#ifndef NUMBER_H_
+#define NUMBER_H_
+
+#include <stddef.h>
+
+// Number parsing straight from a sized span (like a token content), without copying it anywhere
+// and without allocating memory.
+
+typedef enum {
+    NUMBER_OK = 0,
+    NUMBER_INVALID,
+    NUMBER_OUT_OF_RANGE,
+} Number_Status;
+
+// [-]digits
+Number_Status parse_integer(const char *data, size_t size, long *out);
+// [-]digits.digits
+Number_Status parse_float(const char *data, size_t size, double *out);
+
+#endif // !NUMBER_H_
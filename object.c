@@ -0,0 +1,61 @@
+#include <pthread.h>
+#include "./object.h"
+#include "./utils.h"
+
+// The vars may be evaluated by many threads, and two of them can look up keys of the same object at once
+static pthread_mutex_t build_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static Map *build_index(Object object) {
+    pthread_mutex_lock(&build_mutex);
+
+    Map *built = __atomic_load_n(&object.index->positions, __ATOMIC_ACQUIRE);
+
+    if (built != NULL) {
+        pthread_mutex_unlock(&build_mutex);
+
+        return built;
+    }
+
+    Map *positions = map_new(sizeof(size_t));
+
+    for (size_t i = 0; i < object.length; ++i) {
+        Var var = object.data[i];
+
+        // keep the first one with the name, like the scan does
+        if (map_get(positions, var.name.value, var.name.size) == NULL) {
+            map_set(positions, var.name.value, var.name.size, &i);
+        }
+    }
+
+    __atomic_store_n(&object.index->positions, positions, __ATOMIC_RELEASE);
+
+    pthread_mutex_unlock(&build_mutex);
+
+    return positions;
+}
+
+Var *object_get(Object object, const char *key, size_t key_size) {
+    if (object.index == NULL) {
+        for (size_t i = 0; i < object.length; ++i) {
+            Var *var = &object.data[i];
+
+            if (cmp_sized_strings(var->name.value, var->name.size, key, key_size)) return var;
+        }
+
+        return NULL;
+    }
+
+    Map *positions = __atomic_load_n(&object.index->positions, __ATOMIC_ACQUIRE);
+
+    if (positions == NULL) positions = build_index(object);
+
+    size_t *position = map_get(positions, key, key_size);
+
+    return position != NULL ? &object.data[*position] : NULL;
+}
+
+void object_index_free(Object_Index *index) {
+    if (index->positions != NULL) map_free(index->positions);
+
+    index->positions = NULL;
+}
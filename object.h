@@ -0,0 +1,23 @@
+#ifndef OBJECT_H_
+#define OBJECT_H_
+
+#include <stddef.h>
+#include "./parser.h"
+#include "./map.h"
+
+// Objects with less keys than this are just scanned, it's faster than hashing the key
+#define OBJECT_INDEX_MIN_LENGTH 32
+
+// Hash index of the keys of a big object (name -> position in `data`).
+// The parser attaches an empty one to every big object and it's only filled on the first lookup by key.
+// Since it's a pointer, every copy of the object shares it, the evaluated ones too (they keep the same
+// keys in the same order), so it's built once per object of the file.
+struct Object_Index {
+    Map *positions;
+};
+
+// The first var named `key`, or NULL
+Var *object_get(Object object, const char *key, size_t key_size);
+void object_index_free(Object_Index *index);
+
+#endif // !OBJECT_H_
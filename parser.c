@@ -5,30 +5,98 @@
 #include "./parser.h"
 #include "./loc.h"
 #include "./lexer.h"
+#include "./arena.h"
+#include "./number.h"
+#include "./object.h"
+#include "./rope.h"
 
 Var_Data_Types parse_object_variable(Token **ref);
 Var_Data_Types parse_array_variable(Token **ref);
 Var_Data_Types_Indentified parse_fun_call_variable(Token **ref);
 Var_Data_Types_Indentified parse_path_variable(Token **ref);
 
-static Location current_location;
-
+static _Thread_local Location current_location;
+// Every allocation of the document being parsed goes here (see `parse_tokens`).
+// The state of the parser is per thread, so many files can be parsed at the same time (see import.h).
+static _Thread_local Arena *arena;
+
+// Smaller arrays keep a location for each item (for the errors), and they take little space anyway
+#define PACKED_ARRAY_MIN_LENGTH 16
+static _Thread_local Object_Indexes *object_indexes;
+
+// While an array, object, path, argument list or list of indexes is being parsed we don't know how many
+// items it'll have. So its items are pushed to one of these stacks (shared by all of the nested ones, each
+// one on top of its parent's items) and, when it's closed, they are copied to the arena with the exact
+// size. This way a single item array takes the space of a single item.
+static _Thread_local struct { size_t length, capacity; Argument *data; } arguments_stack;
+static _Thread_local struct { size_t length, capacity; Var *data; } vars_stack;
+static _Thread_local struct { size_t length, capacity; String *data; } strings_stack;
+
+#define scratch_begin(stack) (stack)->length
+
+// Move the items pushed since `start` to `out`, and remove them from the stack
+#define scratch_finish(stack, start, out) do { \
+    size_t count = (stack)->length - (start); \
+    (out)->length = count; \
+    (out)->capacity = count; \
+    (out)->data = NULL; \
+    if (count > 0) { \
+        (out)->data = arena_alloc(arena, count * sizeof((out)->data[0])); \
+        memcpy((out)->data, (stack)->data + (start), count * sizeof((out)->data[0])); \
+    } \
+    (stack)->length = (start); \
+} while (0);
+
+// Tokens are stored contiguously and always end with a TK_EOF, so moving forward is just
+// moving to the next slot. We never walk past the TK_EOF.
 void advance_token(Token **ref) {
-    if (ref != NULL && *ref != NULL) *ref = (*ref)->next;
+    if (ref != NULL && *ref != NULL && (*ref)->kind != TK_EOF) ++(*ref);
 }
 
 #define unwrap_ref(ref) *ref;
 
-static String copy_string_as_null_terminated(String string) {
-    String ret = {
-        .value = malloc(string.size + 1),
-        .size = string.size
-    };
+// When the content is released before the parser (see `parse_tokens_batch`)
+static _Thread_local bool copy_content;
+
+// Strings, names and path chunks are views into the file content (so they are not null-terminated),
+// unless the content doesn't outlive the parser.
+static String content_string(char *value, size_t size) {
+    if (!copy_content || size == 0) return (String){.value = value, .size = size};
+
+    return (String){.value = arena_strndup(arena, value, size), .size = size};
+}
+
+// Only the strings with an escape sequence always need a copy, to hold the decoded value.
+static String unescape_string(char *value, size_t size) {
+    if (memchr(value, '\\', size) == NULL) return content_string(value, size);
+
+    char *decoded = arena_alloc(arena, size);
+    size_t decoded_size = 0;
+
+    for (size_t i = 0; i < size; ++i) {
+        char c = value[i];
+
+        // the lexer already made sure that there is a valid char after each '\\'
+        if (c == '\\' && i + 1 < size) {
+            switch (value[++i]) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'b': c = '\b'; break;
+                case 'r': c = '\r'; break;
+                case 'f': c = '\f'; break;
+                default: c = value[i]; break;
+            }
+        }
 
-    memcpy(ret.value, string.value, string.size);
-    ret.value[string.size] = '\0';
+        decoded[decoded_size++] = c;
+    }
+
+    return (String){.value = decoded, .size = decoded_size};
+}
 
-    return ret;
+// The content of a TK_STRING token (or a quoted name or path chunk) without the quotes
+static String unquote_string(Token *token) {
+    return unescape_string(token->content + 1, token->content_size - 2);
 }
 
 // TODO: do not advance the token. Let this job the an outside called
@@ -65,7 +133,7 @@ Token *expect_kind(Token **ref, Token_Kind kind) {
 
     Token *token = *ref;
 
-    *ref = token->next;
+    advance_token(ref);
 
     return token;
 }
@@ -114,7 +182,7 @@ Token *expect_two_kinds(Token **ref, Token_Kind a, Token_Kind b) {
 
     Token *token = *ref;
 
-    (*ref) = token->next;
+    advance_token(ref);
 
     return token;
 }
@@ -125,10 +193,7 @@ Var_Data_Types parse_string_variable(Token **tokens) {
     current_location = var_rhs->loc;
 
     return (Var_Data_Types){
-        .string = copy_string_as_null_terminated((String){
-            .size = var_rhs->content_size - 2, // removing quotes
-            .value = var_rhs->content + 1
-        })
+        .string = unquote_string(var_rhs)
     };
 }
 
@@ -137,27 +202,32 @@ Var_Data_Types parse_integer_variable(Token **tokens) {
 
     current_location = var_rhs->loc;
 
-    char *const number = calloc(var_rhs->content_size, sizeof(char));
-
-    char *endptr;
-
-    memcpy(number, var_rhs->content, var_rhs->content_size * sizeof(char));
-
-    long integer = strtol(number, &endptr, 10);
+    long integer;
 
-    if (*endptr != '\0') {
-        fprintf(
-            stderr,
-            LOC_ERROR_FMT" Invalid integer \033[1;35m%.*s\033[0m\n",
-            LOC_ERROR_ARG(var_rhs->loc),
-            (int)var_rhs->content_size,
-            var_rhs->content
-        );
-        exit(1);
+    switch (parse_integer(var_rhs->content, var_rhs->content_size, &integer)) {
+        case NUMBER_OK: break;
+        case NUMBER_INVALID: {
+            fprintf(
+                stderr,
+                LOC_ERROR_FMT" Invalid integer \033[1;35m%.*s\033[0m\n",
+                LOC_ERROR_ARG(var_rhs->loc),
+                (int)var_rhs->content_size,
+                var_rhs->content
+            );
+            exit(1);
+        }
+        case NUMBER_OUT_OF_RANGE: {
+            fprintf(
+                stderr,
+                LOC_ERROR_FMT" Integer \033[1;35m%.*s\033[0m out of range\n",
+                LOC_ERROR_ARG(var_rhs->loc),
+                (int)var_rhs->content_size,
+                var_rhs->content
+            );
+            exit(1);
+        }
     }
 
-    free(number);
-
     return (Var_Data_Types){
         .integer = {
             .value = integer
@@ -174,17 +244,9 @@ static Var create_variable_from_kind(Location loc, Var_Kind kind, Token* var_lhs
     };
 
     if (var_lhs->kind == TK_STRING) {
-        var.name.size = var_lhs->content_size - 2;
-        var.name.value = malloc(var.name.size + 1);
-
-        memcpy(var.name.value, var_lhs->content+1, var.name.size);
-        var.name.value[var.name.size] = '\0';
+        var.name = unquote_string(var_lhs);
     } else {
-        var.name.value = malloc(var_lhs->content_size + 1);
-        var.name.size = var_lhs->content_size;
-
-        memcpy(var.name.value, var_lhs->content, var_lhs->content_size);
-        var.name.value[var_lhs->content_size] = '\0';
+        var.name = content_string(var_lhs->content, var_lhs->content_size);
     }
 
     switch (kind) {
@@ -301,27 +363,32 @@ Var_Data_Types parse_float_variable(Token **tokens) {
 
     current_location = var_rhs->loc;
 
-    char *const number = calloc(var_rhs->content_size, sizeof(char));
-
-    char *endptr;
+    double floating;
 
-    memcpy(number, var_rhs->content, var_rhs->content_size * sizeof(char));
-
-    double floating = strtod(number, &endptr);
-
-    if (*endptr != '\0') {
-        fprintf(
-            stderr, 
-            LOC_ERROR_FMT" Invalid float \033[1;35m%.*s\033[0m\n",
-            LOC_ERROR_ARG(var_rhs->loc),
-            (int)var_rhs->content_size,
-            var_rhs->content
-        );
-        exit(1);
+    switch (parse_float(var_rhs->content, var_rhs->content_size, &floating)) {
+        case NUMBER_OK: break;
+        case NUMBER_INVALID: {
+            fprintf(
+                stderr,
+                LOC_ERROR_FMT" Invalid float \033[1;35m%.*s\033[0m\n",
+                LOC_ERROR_ARG(var_rhs->loc),
+                (int)var_rhs->content_size,
+                var_rhs->content
+            );
+            exit(1);
+        }
+        case NUMBER_OUT_OF_RANGE: {
+            fprintf(
+                stderr,
+                LOC_ERROR_FMT" Float \033[1;35m%.*s\033[0m out of range\n",
+                LOC_ERROR_ARG(var_rhs->loc),
+                (int)var_rhs->content_size,
+                var_rhs->content
+            );
+            exit(1);
+        }
     }
 
-    free(number);
-
     return (Var_Data_Types){
         .floating = {
             .value = floating
@@ -350,9 +417,11 @@ Var_Data_Types parse_bool_variable(bool value, Token **ref) {
     };
 }
 
-Array parse_indexes(Token **ref) {
+Indexes parse_indexes(Token **ref) {
     Array indexes = {0};
 
+    size_t start = scratch_begin(&arguments_stack);
+
     while ((*ref)->kind == TK_LSQUARE) {
         advance_token(ref);
 
@@ -392,10 +461,12 @@ Array parse_indexes(Token **ref) {
 
         (void)expect_kind(ref, TK_RSQUARE);
 
-        array_append(&indexes, index_argument);
+        array_append(&arguments_stack, index_argument);
     }
 
-    return indexes;
+    scratch_finish(&arguments_stack, start, &indexes);
+
+    return (Indexes){.length = indexes.length, .data = indexes.data};
 }
 
 Var_Data_Types_Indentified parse_path_variable(Token **ref) {
@@ -411,54 +482,45 @@ Var_Data_Types_Indentified parse_path_variable(Token **ref) {
         }
     };
 
-    Token *last = NULL;
     Token *current = unwrap_ref(ref);
 
     int chunks = 0;
 
+    size_t start = scratch_begin(&strings_stack);
+
     while (current->kind == TK_PATH_CHUNK) {
         chunks++;
 
         String string;
 
         if (current->content[0] == '"') {
-            string = copy_string_as_null_terminated((String){
-                .value = current->content + 1,
-                .size = current->content_size - 2
-            });
+            string = unquote_string(current);
         } else {
-            string = copy_string_as_null_terminated((String){
-                .value = current->content,
-                .size = current->content_size
-            });
+            string = content_string(current->content, current->content_size);
         }
 
-        array_append(&var.path, string);
+        array_append(&strings_stack, string);
 
-        last = current;
-        current = current->next;
+        advance_token(&current);
     }
 
-    if (chunks != 1) {
-        if (last == NULL) {
-            fprintf(
-                stderr,
-                LOC_ERROR_FMT" Invalid syntax. Invalid path\n",
-                LOC_ERROR_ARG(current->loc)
-            );
-        } else {
-            fprintf(
-                stderr,
-                LOC_ERROR_FMT" Invalid syntax. Invalid path\n",
-                LOC_ERROR_ARG(last->loc)
-            );
-        }
+    scratch_finish(&strings_stack, start, &var.path);
+
+    if (chunks == 0) {
+        fprintf(
+            stderr,
+            LOC_ERROR_FMT" Invalid syntax. Invalid path\n",
+            LOC_ERROR_ARG(current->loc)
+        );
         exit(1);
     }
 
+    var.path.route = arena_alloc(arena, sizeof(Path_Route));
+    var.path.route->slots = chunks > 1 ? arena_alloc(arena, (chunks - 1) * sizeof(size_t)) : NULL;
+
     *ref = current;
 
-    Array indexes = parse_indexes(ref);
+    Indexes indexes = parse_indexes(ref);
 
     return (Var_Data_Types_Indentified){
         .kind = VK_PATH,
@@ -478,20 +540,21 @@ Var_Data_Types_Indentified parse_fun_call_variable(Token **ref) {
 
     Var_Data_Types_Indentified var = {
         .kind = VK_FUN_CALL,
-        .as.fun_call = calloc(1, sizeof(Fun_Call)),
+        .as.fun_call = arena_alloc(arena, sizeof(Fun_Call)),
     };
 
-    var.as.fun_call->name = copy_string_as_null_terminated((String){
-        .value = fun_name->content,
-        .size = fun_name->content_size
-    });
+    *var.as.fun_call = (Fun_Call){0};
+
+    var.as.fun_call->name = content_string(fun_name->content, fun_name->content_size);
 
     if ((*ref)->kind != TK_RPAREN) {
         Token* current = *ref;
 
+        size_t start = scratch_begin(&arguments_stack);
+
         while (current->kind != TK_RPAREN) {
             if (current->kind == TK_NEWLINE) {
-                current = current->next;
+                advance_token(&current);
                 continue;
             }
 
@@ -556,11 +619,13 @@ Var_Data_Types_Indentified parse_fun_call_variable(Token **ref) {
                 }
             }
 
-            array_append(&var.as.fun_call->arguments, argument);
+            array_append(&arguments_stack, argument);
 
-            if (current->kind == TK_COMMA) current = current->next;
+            if (current->kind == TK_COMMA) advance_token(&current);
         }
 
+        scratch_finish(&arguments_stack, start, &var.as.fun_call->arguments);
+
         *ref = current;
     }
 
@@ -573,7 +638,71 @@ Var_Data_Types_Indentified parse_fun_call_variable(Token **ref) {
     return var;
 }
 
+// Only the items that are plain literals of `kind`
+static bool all_items_are(Argument_Kind kind, const Argument *items, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        if (items[i].kind != kind || items[i].metadata.indexes.length > 0) return false;
+    }
+
+    return true;
+}
+
+// Moves the items pushed since `start` to `array`, packing them when they are all integers or all floats
+static void finish_array(size_t start, Array *array, Location loc) {
+    const Argument *items = arguments_stack.data + start;
+    size_t length = arguments_stack.length - start;
+
+    if (length < PACKED_ARRAY_MIN_LENGTH) {
+        scratch_finish(&arguments_stack, start, array);
+        return;
+    }
+
+    Array_Packed packed = {.loc = loc};
+
+    if (all_items_are(AK_INTEGER, items, length)) {
+        packed.packing = ARRAY_INTEGERS;
+        packed.integers = arena_alloc(arena, length * sizeof(long));
+
+        for (size_t i = 0; i < length; ++i) packed.integers[i] = items[i].as.integer.value;
+    } else if (all_items_are(AK_FLOAT, items, length)) {
+        packed.packing = ARRAY_FLOATS;
+        packed.floats = arena_alloc(arena, length * sizeof(double));
+
+        for (size_t i = 0; i < length; ++i) packed.floats[i] = items[i].as.floating.value;
+    } else {
+        scratch_finish(&arguments_stack, start, array);
+        return;
+    }
+
+    array->length = length;
+    array->capacity = length;
+    array->data = NULL;
+    array->packed = arena_alloc(arena, sizeof(Array_Packed));
+    *array->packed = packed;
+
+    arguments_stack.length = start;
+}
+
+Argument array_at(Array array, size_t i) {
+    if (array.packed == NULL) return array.data[i];
+
+    const Array_Packed *packed = array.packed;
+
+    switch (packed->packing) {
+        case ARRAY_INTEGERS: return (Argument){.kind = AK_INTEGER, .loc = packed->loc, .as.integer.value = packed->integers[i], .evaluated = true};
+        case ARRAY_FLOATS: return (Argument){.kind = AK_FLOAT, .loc = packed->loc, .as.floating.value = packed->floats[i], .evaluated = true};
+        case ARRAY_ROPE: return rope_at(packed->rope, i);
+        default: return array.data[i];
+    }
+}
+
+Array_Packing array_packing(Array array) {
+    return array.packed != NULL ? array.packed->packing : ARRAY_ARGUMENTS;
+}
+
 Var_Data_Types parse_array_variable(Token **ref) {
+    Location array_location = (*ref)->loc;
+
     advance_token(ref);
 
     current_location = (*ref)->loc;
@@ -588,30 +717,34 @@ Var_Data_Types parse_array_variable(Token **ref) {
 
     Token *current = unwrap_ref(ref);
 
+    size_t start = scratch_begin(&arguments_stack);
+
     while (current->kind != TK_EOF && current->kind != TK_RSQUARE) {
         if (current->kind == TK_NEWLINE) {
-            current = current->next;
+            advance_token(&current);
             continue;
         }
 
+        Argument argument = {0};
+
         switch (current->kind) {
-            case TK_STRING: array_append(&var.array, create_argument_from_kind(current_location, VK_STRING, parse_string_variable(&current), EMPTY_METADATA)); break;
-            case TK_INTEGER: array_append(&var.array, create_argument_from_kind(current_location, VK_INTEGER, parse_integer_variable(&current), EMPTY_METADATA)); break;
-            case TK_FLOAT: array_append(&var.array, create_argument_from_kind(current_location, VK_FLOAT, parse_float_variable(&current), EMPTY_METADATA)); break;
-            case TK_TRUE: array_append(&var.array, create_argument_from_kind(current_location, VK_BOOLEAN, parse_bool_variable(true, &current), EMPTY_METADATA)); break;
-            case TK_FALSE: array_append(&var.array, create_argument_from_kind(current_location, VK_BOOLEAN, parse_bool_variable(false, &current), EMPTY_METADATA)); break;
-            case TK_NIL: array_append(&var.array, create_argument_from_kind(current_location, VK_NIL, parse_nil_variable(&current), EMPTY_METADATA)); break;
-            case TK_LSQUARE: array_append(&var.array, create_argument_from_kind(current_location, VK_ARRAY, parse_array_variable(&current), EMPTY_METADATA)); break;
-            case TK_LBRACE: array_append(&var.array, create_argument_from_kind(current_location, VK_OBJECT, parse_object_variable(&current), EMPTY_METADATA)); break;
+            case TK_STRING: argument = create_argument_from_kind(current_location, VK_STRING, parse_string_variable(&current), EMPTY_METADATA); break;
+            case TK_INTEGER: argument = create_argument_from_kind(current_location, VK_INTEGER, parse_integer_variable(&current), EMPTY_METADATA); break;
+            case TK_FLOAT: argument = create_argument_from_kind(current_location, VK_FLOAT, parse_float_variable(&current), EMPTY_METADATA); break;
+            case TK_TRUE: argument = create_argument_from_kind(current_location, VK_BOOLEAN, parse_bool_variable(true, &current), EMPTY_METADATA); break;
+            case TK_FALSE: argument = create_argument_from_kind(current_location, VK_BOOLEAN, parse_bool_variable(false, &current), EMPTY_METADATA); break;
+            case TK_NIL: argument = create_argument_from_kind(current_location, VK_NIL, parse_nil_variable(&current), EMPTY_METADATA); break;
+            case TK_LSQUARE: argument = create_argument_from_kind(current_location, VK_ARRAY, parse_array_variable(&current), EMPTY_METADATA); break;
+            case TK_LBRACE: argument = create_argument_from_kind(current_location, VK_OBJECT, parse_object_variable(&current), EMPTY_METADATA); break;
             case TK_PATH_ROOT: {
                 Var_Data_Types_Indentified path = parse_path_variable(&current);
 
                 switch (path.kind) {
                     case VK_PATH: {
-                        array_append(&var.array, create_argument_from_kind(current_location, VK_PATH, path.as, path.metadata))
+                        argument = create_argument_from_kind(current_location, VK_PATH, path.as, path.metadata);
                     } break;
                     case VK_FUN_CALL: {
-                        array_append(&var.array, create_argument_from_kind(current_location, VK_FUN_CALL, path.as, path.metadata))
+                        argument = create_argument_from_kind(current_location, VK_FUN_CALL, path.as, path.metadata);
                     } break;
                     default: break;
                 }
@@ -619,7 +752,7 @@ Var_Data_Types parse_array_variable(Token **ref) {
             case TK_SYM: {
                 Var_Data_Types_Indentified fun_call = parse_fun_call_variable(&current);
 
-                array_append(&var.array, create_argument_from_kind(current_location, VK_FUN_CALL, fun_call.as, fun_call.metadata));
+                argument = create_argument_from_kind(current_location, VK_FUN_CALL, fun_call.as, fun_call.metadata);
             } break;
             default: {
                 fprintf(
@@ -634,11 +767,15 @@ Var_Data_Types parse_array_variable(Token **ref) {
             }
         }
 
+        array_append(&arguments_stack, argument);
+
         if (current->kind == TK_COMMA) {
-            current = current->next;
+            advance_token(&current);
         }
     }
 
+    finish_array(start, &var.array, array_location);
+
     (void)expect_kind(&current, TK_RSQUARE);
 
     advance_token(ref);
@@ -662,33 +799,37 @@ Var_Data_Types parse_object_variable(Token **ref) {
 
     Token *current = unwrap_ref(ref);
 
+    size_t start = scratch_begin(&vars_stack);
+
     while (current->kind != TK_EOF && current->kind != TK_RBRACE) {
         if (current->kind == TK_NEWLINE) {
-            current = current->next;
+            advance_token(&current);
             continue;
         }
 
         Token *key_lhs = expect_two_kinds(&current, TK_SYM, TK_STRING);
         (void)expect_kind(&current, TK_EQUAL);
 
+        Var item = {0};
+
         switch (current->kind) {
-            case TK_STRING: array_append(&var.object, create_variable_from_kind(current_location, VK_STRING, key_lhs, parse_string_variable(&current), EMPTY_METADATA)); break;
-            case TK_INTEGER: array_append(&var.object, create_variable_from_kind(current_location, VK_INTEGER, key_lhs, parse_integer_variable(&current), EMPTY_METADATA)); break;
-            case TK_FLOAT: array_append(&var.object, create_variable_from_kind(current_location, VK_FLOAT, key_lhs, parse_float_variable(&current), EMPTY_METADATA)); break;
-            case TK_TRUE: array_append(&var.object, create_variable_from_kind(current_location, VK_BOOLEAN, key_lhs, parse_bool_variable(true, &current), EMPTY_METADATA)); break;
-            case TK_FALSE: array_append(&var.object, create_variable_from_kind(current_location, VK_BOOLEAN, key_lhs, parse_bool_variable(false, &current), EMPTY_METADATA)); break;
-            case TK_NIL: array_append(&var.object, create_variable_from_kind(current_location, VK_NIL, key_lhs, parse_nil_variable(&current), EMPTY_METADATA)); break;
-            case TK_LSQUARE: array_append(&var.object, create_variable_from_kind(current_location, VK_ARRAY, key_lhs, parse_array_variable(&current), EMPTY_METADATA)); break;
-            case TK_LBRACE: array_append(&var.object, create_variable_from_kind(current_location, VK_OBJECT, key_lhs, parse_object_variable(&current), EMPTY_METADATA)); break;
+            case TK_STRING: item = create_variable_from_kind(current_location, VK_STRING, key_lhs, parse_string_variable(&current), EMPTY_METADATA); break;
+            case TK_INTEGER: item = create_variable_from_kind(current_location, VK_INTEGER, key_lhs, parse_integer_variable(&current), EMPTY_METADATA); break;
+            case TK_FLOAT: item = create_variable_from_kind(current_location, VK_FLOAT, key_lhs, parse_float_variable(&current), EMPTY_METADATA); break;
+            case TK_TRUE: item = create_variable_from_kind(current_location, VK_BOOLEAN, key_lhs, parse_bool_variable(true, &current), EMPTY_METADATA); break;
+            case TK_FALSE: item = create_variable_from_kind(current_location, VK_BOOLEAN, key_lhs, parse_bool_variable(false, &current), EMPTY_METADATA); break;
+            case TK_NIL: item = create_variable_from_kind(current_location, VK_NIL, key_lhs, parse_nil_variable(&current), EMPTY_METADATA); break;
+            case TK_LSQUARE: item = create_variable_from_kind(current_location, VK_ARRAY, key_lhs, parse_array_variable(&current), EMPTY_METADATA); break;
+            case TK_LBRACE: item = create_variable_from_kind(current_location, VK_OBJECT, key_lhs, parse_object_variable(&current), EMPTY_METADATA); break;
             case TK_PATH_ROOT: {
                 Var_Data_Types_Indentified path = parse_path_variable(&current);
 
                 switch (path.kind) {
                     case VK_PATH: {
-                        array_append(&var.object, create_variable_from_kind(current_location, VK_PATH, key_lhs, path.as, path.metadata));
+                        item = create_variable_from_kind(current_location, VK_PATH, key_lhs, path.as, path.metadata);
                     } break;
                     case VK_FUN_CALL: {
-                        array_append(&var.object, create_variable_from_kind(current_location, VK_FUN_CALL, key_lhs, path.as, path.metadata));
+                        item = create_variable_from_kind(current_location, VK_FUN_CALL, key_lhs, path.as, path.metadata);
                     } break;
                     default: break;
                 }
@@ -696,7 +837,7 @@ Var_Data_Types parse_object_variable(Token **ref) {
             case TK_SYM: {
                 Var_Data_Types_Indentified fun_call = parse_fun_call_variable(&current);
 
-                array_append(&var.object, create_variable_from_kind(current_location, VK_FUN_CALL, key_lhs, fun_call.as, fun_call.metadata));
+                item = create_variable_from_kind(current_location, VK_FUN_CALL, key_lhs, fun_call.as, fun_call.metadata);
             } break;
             default: {
                 fprintf(
@@ -711,11 +852,22 @@ Var_Data_Types parse_object_variable(Token **ref) {
             }
         }
 
+        array_append(&vars_stack, item);
+
         if (current->kind == TK_COMMA) {
-            current = current->next;
+            advance_token(&current);
         }
     }
 
+    scratch_finish(&vars_stack, start, &var.object);
+
+    if (var.object.length >= OBJECT_INDEX_MIN_LENGTH) {
+        var.object.index = arena_alloc(arena, sizeof(Object_Index));
+        *var.object.index = (Object_Index){0};
+
+        array_append(object_indexes, var.object.index);
+    }
+
     (void)expect_kind(&current, TK_RBRACE);
 
     advance_token(ref);
@@ -725,40 +877,39 @@ Var_Data_Types parse_object_variable(Token **ref) {
     return var;
 }
 
-Parser parse_tokens(Token *head) {
-    if (head == NULL) return (Parser){0};
-
-    Parser parser = {0};
-
+// Parse the top-level vars until the TK_EOF, they are left in `vars_stack`
+static void parse_vars(Token *head) {
     Token *current = head;
 
     while (current->kind != TK_EOF) {
         if (current->kind == TK_NEWLINE) {
-            current = current->next;
+            advance_token(&current);
             continue;
         }
 
         Token *var_lhs = expect_two_kinds(&current, TK_SYM, TK_STRING);
         (void)expect_kind(&current, TK_EQUAL);
 
+        Var item = {0};
+
         switch (current->kind) {
-            case TK_STRING: array_append(&parser, create_variable_from_kind(current_location, VK_STRING, var_lhs, parse_string_variable(&current), EMPTY_METADATA)); break;
-            case TK_INTEGER: array_append(&parser, create_variable_from_kind(current_location, VK_INTEGER, var_lhs, parse_integer_variable(&current), EMPTY_METADATA)); break;
-            case TK_FLOAT: array_append(&parser, create_variable_from_kind(current_location, VK_FLOAT, var_lhs, parse_float_variable(&current), EMPTY_METADATA)); break;
-            case TK_TRUE: array_append(&parser, create_variable_from_kind(current_location, VK_BOOLEAN, var_lhs, parse_bool_variable(true, &current), EMPTY_METADATA)); break;
-            case TK_FALSE: array_append(&parser, create_variable_from_kind(current_location, VK_BOOLEAN, var_lhs, parse_bool_variable(false, &current), EMPTY_METADATA)); break;
-            case TK_NIL: array_append(&parser, create_variable_from_kind(current_location, VK_NIL, var_lhs, parse_nil_variable(&current), EMPTY_METADATA)); break;
-            case TK_LSQUARE: array_append(&parser, create_variable_from_kind(current_location, VK_ARRAY, var_lhs, parse_array_variable(&current), EMPTY_METADATA)); break;
-            case TK_LBRACE: array_append(&parser, create_variable_from_kind(current_location, VK_OBJECT, var_lhs, parse_object_variable(&current), EMPTY_METADATA)); break;
+            case TK_STRING: item = create_variable_from_kind(current_location, VK_STRING, var_lhs, parse_string_variable(&current), EMPTY_METADATA); break;
+            case TK_INTEGER: item = create_variable_from_kind(current_location, VK_INTEGER, var_lhs, parse_integer_variable(&current), EMPTY_METADATA); break;
+            case TK_FLOAT: item = create_variable_from_kind(current_location, VK_FLOAT, var_lhs, parse_float_variable(&current), EMPTY_METADATA); break;
+            case TK_TRUE: item = create_variable_from_kind(current_location, VK_BOOLEAN, var_lhs, parse_bool_variable(true, &current), EMPTY_METADATA); break;
+            case TK_FALSE: item = create_variable_from_kind(current_location, VK_BOOLEAN, var_lhs, parse_bool_variable(false, &current), EMPTY_METADATA); break;
+            case TK_NIL: item = create_variable_from_kind(current_location, VK_NIL, var_lhs, parse_nil_variable(&current), EMPTY_METADATA); break;
+            case TK_LSQUARE: item = create_variable_from_kind(current_location, VK_ARRAY, var_lhs, parse_array_variable(&current), EMPTY_METADATA); break;
+            case TK_LBRACE: item = create_variable_from_kind(current_location, VK_OBJECT, var_lhs, parse_object_variable(&current), EMPTY_METADATA); break;
             case TK_PATH_ROOT: {
                 Var_Data_Types_Indentified path = parse_path_variable(&current);
 
                 switch (path.kind) {
                     case VK_PATH: {
-                        array_append(&parser, create_variable_from_kind(current_location, VK_PATH, var_lhs, path.as, path.metadata));
+                        item = create_variable_from_kind(current_location, VK_PATH, var_lhs, path.as, path.metadata);
                     } break;
                     case VK_FUN_CALL: {
-                        array_append(&parser, create_variable_from_kind(current_location, VK_FUN_CALL, var_lhs, path.as, path.metadata));
+                        item = create_variable_from_kind(current_location, VK_FUN_CALL, var_lhs, path.as, path.metadata);
                     } break;
                     default: break;
                 }
@@ -766,7 +917,7 @@ Parser parse_tokens(Token *head) {
             case TK_SYM: {
                 Var_Data_Types_Indentified fun_call = parse_fun_call_variable(&current);
 
-                array_append(&parser, create_variable_from_kind(current_location, VK_FUN_CALL, var_lhs, fun_call.as, fun_call.metadata));
+                item = create_variable_from_kind(current_location, VK_FUN_CALL, var_lhs, fun_call.as, fun_call.metadata);
             } break;
             default: {
                 fprintf(
@@ -780,14 +931,55 @@ Parser parse_tokens(Token *head) {
                 exit(1);
             }
         }
+
+        array_append(&vars_stack, item);
     }
+}
+
+void parse_tokens_batch(Parser *parser, Token *head) {
+    arena = &parser->arena;
+    object_indexes = &parser->object_indexes;
+    copy_content = true;
+
+    parse_vars(head);
+}
+
+void parse_tokens_finish(Parser *parser) {
+    arena = &parser->arena;
+
+    scratch_finish(&vars_stack, 0, parser);
+
+    // the stacks are only needed while parsing
+    array_free(&arguments_stack);
+    array_free(&vars_stack);
+    array_free(&strings_stack);
+
+    arena = NULL;
+    object_indexes = NULL;
+    copy_content = false;
+}
+
+Parser parse_tokens(Token *head) {
+    if (head == NULL) return (Parser){0};
+
+    Parser parser = {0};
+
+    arena = &parser.arena;
+    object_indexes = &parser.object_indexes;
+
+    parse_vars(head);
+    parse_tokens_finish(&parser);
 
     return parser;
 }
 
 void parser_free(Parser parser) {
-    // TODO: implement a better parser free
-    array_free(&parser);
+    for (size_t i = 0; i < parser.object_indexes.length; ++i) {
+        object_index_free(parser.object_indexes.data[i]);
+    }
+
+    array_free(&parser.object_indexes);
+    arena_free(&parser.arena);
 }
 
 const char *var_kind_name(Var_Kind var_kind) {
@@ -3,8 +3,9 @@
 
 #include <stddef.h>
 #include "./lexer.h"
+#include "./utils.h"
+#include "./arena.h"
 
-#define DEFAULT_ARRAY_CAPACITY 100
 #define EMPTY_METADATA (Metadata){0}
 
 typedef struct Var Var;
@@ -39,7 +40,7 @@ typedef enum {
 } Argument_Kind;
 
 typedef struct {
-    // sized string
+    // sized string, it's usually a view into the file content, so it's not null-terminated
     char *value;
     size_t size;
 } String;
@@ -57,30 +58,78 @@ typedef struct {
     double value;
 } Float;
 
-// TODO: it'll be a hashmap (own implemenation)
+typedef struct Object_Index Object_Index;
+
 typedef struct {
     size_t capacity;
     size_t length;
     Var *data;
+
+    // only big objects have one, see object.h
+    Object_Index *index;
 } Object;
 
+typedef enum {
+    ARRAY_ARGUMENTS = 0,
+    ARRAY_INTEGERS,
+    ARRAY_FLOATS,
+    ARRAY_ROPE,
+} Array_Packing;
+
+typedef struct Array_Rope Array_Rope;
+
+// Big literal arrays made only of integers (or only of floats) keep just the numbers, next to each other.
+// The results of `concat_a` point to the arrays they are made of instead (see rope.h).
+typedef struct {
+    Array_Packing packing;
+    union {
+        long *integers;
+        double *floats;
+        Array_Rope *rope;
+    };
+    // the packed items don't have a location of their own, they all use this one
+    Location loc;
+} Array_Packed;
+
 typedef struct {
     size_t capacity;
     size_t length;
     Argument *data;
+
+    // When it's set the items are kept there and `data` is NULL, `array_at` reads an item of any of them.
+    // It's behind a pointer so the other arrays (most of them, and they are in every Argument) stay small.
+    Array_Packed *packed;
 } Array;
 
+#define PATH_NO_SLOT ((size_t)-1)
+
+// Where a path leads, it's allocated by the parser and filled by the interpreter when the file is loaded
+typedef struct {
+    // the top-level var of the first chunk
+    size_t declaration;
+    // For each of the other chunks, the position of the key in the object it's looked up in, known when
+    // that object is a literal. PATH_NO_SLOT when it has to be looked up by name.
+    size_t *slots;
+} Path_Route;
+
 typedef struct {
     size_t capacity;
     size_t length;
-    // Each string in this path have a new allocation, free it yourself
     String *data;
+
+    Path_Route *route;
 } Path;
 
 typedef void* Nil;
 
+// The `[...]` after a value, they are never packed
 typedef struct {
-    Array indexes;
+    size_t length;
+    Argument *data;
+} Indexes;
+
+typedef struct {
+    Indexes indexes;
 } Metadata;
 
 typedef union {
@@ -102,11 +151,24 @@ struct Argument {
     Argument_Data_Types as;
 
     Metadata metadata;
+
+    // Set by the interpreter on the values it produces: `as` is final (nested arrays and objects too)
+    // and there are no indexes, so it can be used as is instead of being evaluated again.
+    bool evaluated;
 };
 
+typedef struct Builtin Builtin;
+typedef struct Native Native;
+
 struct Fun_Call {
     String name;
 
+    // bound by the interpreter when the file is loaded (one of them), NULL until then
+    const Builtin *builtin;
+    const Native *native;
+    // the kinds of the arguments of a native were all checked when it was bound
+    bool typed;
+
     struct {
         size_t length, capacity;
 
@@ -136,7 +198,6 @@ typedef struct {
 
 struct Var {
     Var_Kind kind;
-    // In this specific case, there is a new allocation, so be aware you need to free yourself
     String name;
 
     Location loc;
@@ -144,36 +205,44 @@ struct Var {
     Var_Data_Types as;
 
     Metadata metadata;
+
+    // same as `Argument.evaluated`
+    bool evaluated;
 };
 
+typedef struct {
+    size_t length, capacity;
+    Object_Index **data;
+} Object_Indexes;
+
 typedef struct {
     size_t length, capacity;
     union {
         Var *data;
         Var *vars;
     };
-} Parser;
 
-#define array_append(array, item) do { \
-    if ((array)->length >= (array)->capacity) { \
-        if ((array)->capacity == 0) (array)->capacity = DEFAULT_ARRAY_CAPACITY; \
-        else (array)->capacity = (array)->capacity * 2; \
-        void *output = realloc((array)->data, (array)->capacity * sizeof((array)->data[0])); \
-        assert(output != NULL && "failed to reallocate array"); \
-        (array)->data = output; \
-    } \
-    (array)->data[(array)->length++] = item; \
-} while (0);
-
-#define array_free(array) do { \
-    free((array)->data); \
-    (array)->capacity = DEFAULT_ARRAY_CAPACITY; \
-    (array)->length = 0; \
-} while (0);
-
-#define array_flush(array) (array)->length = 0;
+    // Owns the whole document: the vars, paths, function calls and every nested array or object.
+    // So `parser_free` releases all of it at once.
+    // Names and strings point into the file content, so it must be released only after the parser
+    // (but see `parse_tokens_batch`).
+    Arena arena;
+
+    // The key indexes of the big objects, their tables are allocated (lazily) outside of the arena
+    Object_Indexes object_indexes;
+} Parser;
 
+// The i-th item as an argument (for the packed arrays it's made on the fly, already evaluated)
+Argument array_at(Array array, size_t i);
+Array_Packing array_packing(Array array);
 Parser parse_tokens(Token *head);
+// For a file that is lexed a piece at a time (see stream.h): each batch of tokens (ending with a TK_EOF) holds
+// only whole top-level vars, which are added to `parser`. Their names and strings are copied to its arena,
+// so the tokens and the content can be released as soon as the batch is parsed.
+// Once there are no more batches, `parse_tokens_finish` leaves `parser` like `parse_tokens` would.
+// There can only be one parser taking batches at a time (per thread).
+void parse_tokens_batch(Parser *parser, Token *head);
+void parse_tokens_finish(Parser *parser);
 void parser_free(Parser parser);
 const char *var_kind_name(Var_Kind var_kind);
 const char *argument_kind_name(Argument_Kind kind);
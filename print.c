@@ -6,6 +6,27 @@
 
 #define TAB_SIZE 2
 
+void print_string(String string) {
+    putchar('"');
+
+    for (size_t i = 0; i < string.size; ++i) {
+        char c = string.value[i];
+
+        switch (c) {
+            case '"': printf("\\\""); break;
+            case '\\': printf("\\\\"); break;
+            case '\n': printf("\\n"); break;
+            case '\t': printf("\\t"); break;
+            case '\b': printf("\\b"); break;
+            case '\r': printf("\\r"); break;
+            case '\f': printf("\\f"); break;
+            default: putchar(c); break;
+        }
+    }
+
+    putchar('"');
+}
+
 static void print_argument(Argument argument, int level) {
     switch (argument.kind) {
         case AK_NIL: {
@@ -15,13 +36,14 @@ static void print_argument(Argument argument, int level) {
             printf("%*.s%ld", level, "", argument.as.integer.value);
         } break;
         case AK_STRING: {
-            printf("%*.s\"%s\"", level, "", argument.as.string.value);
+            printf("%*.s", level, "");
+            print_string(argument.as.string);
         } break;
         case AK_ARRAY: {
             printf("%*.s[", level, "");
             if (argument.as.array.length > 0) printf("\n");
             for (size_t i = 0; i < argument.as.array.length; ++i) {
-                print_argument(argument.as.array.data[i], level + TAB_SIZE);
+                print_argument(array_at(argument.as.array, i), level + TAB_SIZE);
 
                 if (i < argument.as.array.length - 1) printf(",\n");
             }
@@ -94,7 +116,7 @@ void print_var(Var var, bool is_inside_array, int level) {
             }
             if (var.as.array.length > 0) printf("\n");
             for (size_t i = 0; i < var.as.array.length; ++i) {
-                print_argument(var.as.array.data[i], level + TAB_SIZE);
+                print_argument(array_at(var.as.array, i), level + TAB_SIZE);
 
                 if (i < var.as.array.length - 1) printf(",\n");
             }
@@ -134,22 +156,18 @@ void print_var(Var var, bool is_inside_array, int level) {
         };
         case VK_STRING: {
             if (is_inside_array) {
-                printf(
-                    "%*.s\"%s\"",
-                    level,
-                    "",
-                    var.as.string.value
-                );
+                printf("%*.s", level, "");
             } else {
                 printf(
-                    "%*.s%.*s = \"%s\"",
+                    "%*.s%.*s = ",
                     level,
                     "",
                     (int)var.name.size,
-                    var.name.value,
-                    var.as.string.value
+                    var.name.value
                 );
             }
+
+            print_string(var.as.string);
         } break;
         case VK_INTEGER: {
             if (is_inside_array) {
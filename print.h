@@ -5,5 +5,7 @@
 #include "./parser.h"
 
 void print_var(Var var, bool is_inside_array, int level);
+// Print a string between quotes, escaping back what was decoded by the parser
+void print_string(String string);
 
 #endif // !PRINT_H_
@@ -0,0 +1,132 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "./rope.h"
+
+// From the arena when there is one, so the rope goes with it
+static void *rope_alloc(Arena *arena, size_t size) {
+    if (arena != NULL) return arena_alloc(arena, size);
+
+    void *data = malloc(size);
+    assert(data != NULL && "failed to allocate rope");
+
+    return data;
+}
+
+static size_t count_leaves(Array array) {
+    if (array_packing(array) != ARRAY_ROPE) return 1;
+
+    size_t count = 0;
+    const Array_Rope *rope = array.packed->rope;
+
+    for (size_t i = 0; i < rope->length; ++i) count += count_leaves(rope->pieces[i]);
+
+    return count;
+}
+
+static void collect_leaves(Array *leaves, size_t *length, Array array) {
+    if (array_packing(array) != ARRAY_ROPE) {
+        leaves[(*length)++] = array;
+        return;
+    }
+
+    const Array_Rope *rope = array.packed->rope;
+
+    for (size_t i = 0; i < rope->length; ++i) collect_leaves(leaves, length, rope->pieces[i]);
+}
+
+static Array copy_items(const Array *arrays, size_t length, size_t total, Arena *arena) {
+    Array out = {.capacity = total, .data = total > 0 ? rope_alloc(arena, total * sizeof(Argument)) : NULL};
+
+    for (size_t i = 0; i < length; ++i) {
+        for (size_t j = 0; j < arrays[i].length; ++j) out.data[out.length++] = array_at(arrays[i], j);
+    }
+
+    return out;
+}
+
+Array rope_concat(const Array *arrays, size_t length, Arena *arena) {
+    size_t total = 0, depth = 0, count = 0;
+
+    for (size_t i = 0; i < length; ++i) {
+        if (arrays[i].length == 0) continue;
+
+        total += arrays[i].length;
+        count++;
+
+        size_t piece_depth = array_packing(arrays[i]) == ARRAY_ROPE ? arrays[i].packed->rope->depth : 0;
+
+        if (piece_depth > depth) depth = piece_depth;
+    }
+
+    if (total < ROPE_MIN_LENGTH) return copy_items(arrays, length, total, arena);
+
+    bool flatten = depth + 1 > ROPE_MAX_DEPTH;
+
+    if (flatten) {
+        count = 0;
+
+        for (size_t i = 0; i < length; ++i) {
+            if (arrays[i].length > 0) count += count_leaves(arrays[i]);
+        }
+
+        depth = 0;
+    }
+
+    if (count == 1) {
+        for (size_t i = 0; i < length; ++i) {
+            if (arrays[i].length > 0) return arrays[i];
+        }
+    }
+
+    Array_Rope *rope = rope_alloc(arena, sizeof(Array_Rope));
+
+    rope->length = 0;
+    rope->pieces = rope_alloc(arena, count * sizeof(Array));
+    rope->ends = rope_alloc(arena, count * sizeof(size_t));
+    rope->depth = depth + 1;
+
+    for (size_t i = 0; i < length; ++i) {
+        if (arrays[i].length == 0) continue;
+
+        if (flatten) {
+            collect_leaves(rope->pieces, &rope->length, arrays[i]);
+        } else {
+            rope->pieces[rope->length++] = arrays[i];
+        }
+    }
+
+    size_t end = 0;
+
+    for (size_t i = 0; i < rope->length; ++i) {
+        end += rope->pieces[i].length;
+        rope->ends[i] = end;
+    }
+
+    Array_Packed *packed = rope_alloc(arena, sizeof(Array_Packed));
+
+    *packed = (Array_Packed){.packing = ARRAY_ROPE, .rope = rope};
+
+    return (Array){
+        .capacity = total,
+        .length = total,
+        .data = NULL,
+        .packed = packed
+    };
+}
+
+Argument rope_at(const Array_Rope *rope, size_t i) {
+    // the first piece that ends after `i`
+    size_t low = 0, high = rope->length - 1;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+
+        if (rope->ends[middle] <= i) low = middle + 1;
+        else high = middle;
+    }
+
+    size_t start = low > 0 ? rope->ends[low - 1] : 0;
+
+    return array_at(rope->pieces[low], i - start);
+}
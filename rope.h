@@ -0,0 +1,29 @@
+#ifndef ROPE_H_
+#define ROPE_H_
+
+#include <stddef.h>
+#include "./parser.h"
+#include "./arena.h"
+
+// Results with less items than this are just copied, a flat array is cheaper to read
+#define ROPE_MIN_LENGTH 32
+// Deeper ropes are rebuilt with only the leaves as pieces, so reading an item stays O(log n)
+#define ROPE_MAX_DEPTH 16
+
+// An array made of other arrays (what `concat_a` returns), the items of the pieces are not copied.
+// The pieces are never modified after they are evaluated, so any number of ropes can share them.
+struct Array_Rope {
+    size_t length;
+    Array *pieces;
+    // ends[i] is the number of items in pieces[0..i], it's how `rope_at` finds the piece of an item
+    size_t *ends;
+    // 1 when none of the pieces is a rope
+    size_t depth;
+};
+
+// The concatenation of the evaluated `arrays`, it can be one of them when the others are empty.
+// What it allocates comes from `arena`, or from malloc (and it's never released) when it's NULL.
+Array rope_concat(const Array *arrays, size_t length, Arena *arena);
+Argument rope_at(const Array_Rope *rope, size_t i);
+
+#endif // !ROPE_H_
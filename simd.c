@@ -0,0 +1,427 @@
+#include "./simd.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+typedef size_t (*Scan_Fn)(const char *data, size_t size);
+
+typedef struct {
+    const char *name;
+    Scan_Fn skip_whitespace;
+    Scan_Fn find_newline;
+    Scan_Fn find_string_special;
+    Scan_Fn count_newlines;
+    long (*sum_integers)(const long *data, size_t length);
+    double (*sum_floats)(const double *data, size_t length);
+} Simd_Impl;
+
+// scalar
+
+static bool is_whitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static size_t scalar_skip_whitespace(const char *data, size_t size) {
+    size_t i = 0;
+
+    while (i < size && is_whitespace(data[i])) ++i;
+
+    return i;
+}
+
+static size_t scalar_find_newline(const char *data, size_t size) {
+    size_t i = 0;
+
+    while (i < size && data[i] != '\n') ++i;
+
+    return i;
+}
+
+static size_t scalar_find_string_special(const char *data, size_t size) {
+    size_t i = 0;
+
+    while (i < size && data[i] != '"' && data[i] != '\\' && data[i] != '\n') ++i;
+
+    return i;
+}
+
+static size_t scalar_count_newlines(const char *data, size_t size) {
+    size_t count = 0;
+
+    for (size_t i = 0; i < size; ++i) count += data[i] == '\n';
+
+    return count;
+}
+
+// The integers wrap around on overflow (unsigned, so it's not undefined)
+static long scalar_sum_integers(const long *data, size_t length) {
+    uint64_t sum = 0;
+
+    for (size_t i = 0; i < length; ++i) sum += (uint64_t)data[i];
+
+    return (long)sum;
+}
+
+// Same order as the vectorized ones: 4 lanes, lane k adds the items i where i % 4 == k, then
+// (lane 0 + lane 1) + (lane 2 + lane 3), then the remaining items one by one
+static double scalar_sum_floats(const double *data, size_t length) {
+    double lanes[4] = {0};
+    size_t i = 0;
+
+    for (; i + 4 <= length; i += 4) {
+        lanes[0] += data[i];
+        lanes[1] += data[i + 1];
+        lanes[2] += data[i + 2];
+        lanes[3] += data[i + 3];
+    }
+
+    double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+    for (; i < length; ++i) sum += data[i];
+
+    return sum;
+}
+
+#ifdef SIMD_X86
+
+// sse2 (16 bytes at a time)
+
+static size_t sse2_skip_whitespace(const char *data, size_t size) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i cr = _mm_set1_epi8('\r');
+
+    size_t i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+            _mm_cmpeq_epi8(chunk, cr)
+        );
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(hits) ^ 0xFFFFu;
+
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+
+    return i + scalar_skip_whitespace(data + i, size - i);
+}
+
+static size_t sse2_find_newline(const char *data, size_t size) {
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    size_t i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+
+    return i + scalar_find_newline(data + i, size - i);
+}
+
+static size_t sse2_find_string_special(const char *data, size_t size) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    size_t i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+            _mm_cmpeq_epi8(chunk, newline)
+        );
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(hits);
+
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+
+    return i + scalar_find_string_special(data + i, size - i);
+}
+
+static size_t sse2_count_newlines(const char *data, size_t size) {
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    size_t count = 0;
+    size_t i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+
+        count += __builtin_popcount((unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+    }
+
+    return count + scalar_count_newlines(data + i, size - i);
+}
+
+static long sse2_sum_integers(const long *data, size_t length) {
+    __m128i lanes = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 2 <= length; i += 2) {
+        lanes = _mm_add_epi64(lanes, _mm_loadu_si128((const __m128i *)(data + i)));
+    }
+
+    int64_t parts[2];
+    _mm_storeu_si128((__m128i *)parts, lanes);
+
+    return (long)((uint64_t)parts[0] + (uint64_t)parts[1] + (uint64_t)scalar_sum_integers(data + i, length - i));
+}
+
+static double sse2_sum_floats(const double *data, size_t length) {
+    __m128d low = _mm_setzero_pd();  // lanes 0 and 1
+    __m128d high = _mm_setzero_pd(); // lanes 2 and 3
+    size_t i = 0;
+
+    for (; i + 4 <= length; i += 4) {
+        low = _mm_add_pd(low, _mm_loadu_pd(data + i));
+        high = _mm_add_pd(high, _mm_loadu_pd(data + i + 2));
+    }
+
+    double lanes[4];
+    _mm_storeu_pd(lanes, low);
+    _mm_storeu_pd(lanes + 2, high);
+
+    double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+    for (; i < length; ++i) sum += data[i];
+
+    return sum;
+}
+
+// avx2 (32 bytes at a time)
+
+__attribute__((target("avx2")))
+static size_t avx2_skip_whitespace(const char *data, size_t size) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i cr = _mm256_set1_epi8('\r');
+
+    size_t i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space), _mm256_cmpeq_epi8(chunk, tab)),
+            _mm256_cmpeq_epi8(chunk, cr)
+        );
+        uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(hits);
+
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+
+    return i + sse2_skip_whitespace(data + i, size - i);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2_find_newline(const char *data, size_t size) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    size_t i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(data + i));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline));
+
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+
+    return i + sse2_find_newline(data + i, size - i);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2_find_string_special(const char *data, size_t size) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    size_t i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+            _mm256_cmpeq_epi8(chunk, newline)
+        );
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(hits);
+
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+
+    return i + sse2_find_string_special(data + i, size - i);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t avx2_count_newlines(const char *data, size_t size) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    size_t count = 0;
+    size_t i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(data + i));
+
+        count += __builtin_popcount((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+    }
+
+    return count + sse2_count_newlines(data + i, size - i);
+}
+
+__attribute__((target("avx2")))
+static long avx2_sum_integers(const long *data, size_t length) {
+    __m256i lanes = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 4 <= length; i += 4) {
+        lanes = _mm256_add_epi64(lanes, _mm256_loadu_si256((const __m256i *)(data + i)));
+    }
+
+    int64_t parts[4];
+    _mm256_storeu_si256((__m256i *)parts, lanes);
+
+    uint64_t sum = (uint64_t)parts[0] + (uint64_t)parts[1] + (uint64_t)parts[2] + (uint64_t)parts[3];
+
+    return (long)(sum + (uint64_t)scalar_sum_integers(data + i, length - i));
+}
+
+__attribute__((target("avx2")))
+static double avx2_sum_floats(const double *data, size_t length) {
+    __m256d lanes = _mm256_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 4 <= length; i += 4) {
+        lanes = _mm256_add_pd(lanes, _mm256_loadu_pd(data + i));
+    }
+
+    double parts[4];
+    _mm256_storeu_pd(parts, lanes);
+
+    double sum = (parts[0] + parts[1]) + (parts[2] + parts[3]);
+
+    for (; i < length; ++i) sum += data[i];
+
+    return sum;
+}
+
+#endif // SIMD_X86
+
+static const Simd_Impl scalar_impl = {
+    .name = "scalar",
+    .skip_whitespace = scalar_skip_whitespace,
+    .find_newline = scalar_find_newline,
+    .find_string_special = scalar_find_string_special,
+    .count_newlines = scalar_count_newlines,
+    .sum_integers = scalar_sum_integers,
+    .sum_floats = scalar_sum_floats,
+};
+
+#ifdef SIMD_X86
+static const Simd_Impl sse2_impl = {
+    .name = "sse2",
+    .skip_whitespace = sse2_skip_whitespace,
+    .find_newline = sse2_find_newline,
+    .find_string_special = sse2_find_string_special,
+    .count_newlines = sse2_count_newlines,
+    .sum_integers = sse2_sum_integers,
+    .sum_floats = sse2_sum_floats,
+};
+
+static const Simd_Impl avx2_impl = {
+    .name = "avx2",
+    .skip_whitespace = avx2_skip_whitespace,
+    .find_newline = avx2_find_newline,
+    .find_string_special = avx2_find_string_special,
+    .count_newlines = avx2_count_newlines,
+    .sum_integers = avx2_sum_integers,
+    .sum_floats = avx2_sum_floats,
+};
+#endif
+
+static const Simd_Impl *impl = &scalar_impl;
+
+// Runs before main, so the selection is done once and never changes while other threads are running.
+// EVALSET_SIMD=scalar|sse2|avx2 can be used to force (or downgrade) the implementation, which is handy
+// to compare them.
+__attribute__((constructor))
+static void simd_select_implementation(void) {
+    const char *forced = getenv("EVALSET_SIMD");
+
+    if (forced != NULL && simd_use_implementation(forced)) return;
+
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        impl = &avx2_impl;
+    } else {
+        // sse2 is part of the x86_64 baseline, so it is always there
+        impl = &sse2_impl;
+    }
+#endif
+}
+
+bool simd_use_implementation(const char *name) {
+    if (strcmp(name, "scalar") == 0) {
+        impl = &scalar_impl;
+        return true;
+    }
+
+#ifdef SIMD_X86
+    if (strcmp(name, "sse2") == 0) {
+        impl = &sse2_impl;
+        return true;
+    }
+
+    __builtin_cpu_init();
+
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        impl = &avx2_impl;
+        return true;
+    }
+#endif
+
+    return false;
+}
+
+size_t simd_skip_whitespace(const char *data, size_t size) {
+    // Most of the tokens are separated by a single space (or none at all), so don't pay for the
+    // vectorized scan unless there is an actual run of whitespaces
+    if (size == 0 || !is_whitespace(data[0])) return 0;
+    if (size == 1 || !is_whitespace(data[1])) return 1;
+
+    return impl->skip_whitespace(data, size);
+}
+
+size_t simd_find_newline(const char *data, size_t size) {
+    return impl->find_newline(data, size);
+}
+
+size_t simd_find_string_special(const char *data, size_t size) {
+    return impl->find_string_special(data, size);
+}
+
+size_t simd_count_newlines(const char *data, size_t size) {
+    return impl->count_newlines(data, size);
+}
+
+const char *simd_implementation_name(void) {
+    return impl->name;
+}
+
+long simd_sum_integers(const long *data, size_t length) {
+    return impl->sum_integers(data, length);
+}
+
+double simd_sum_floats(const double *data, size_t length) {
+    return impl->sum_floats(data, length);
+}
@@ -0,0 +1,35 @@
+#ifndef SIMD_H_
+#define SIMD_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Vectorized scanning (and summing) helpers.
+// Each one has a scalar version and, on x86, SSE2 and AVX2 versions. The best one is selected at
+// runtime (based on what the cpu supports), so the same binary works everywhere.
+//
+// All of them receive a sized buffer (not null-terminated). The scans return the index of the first
+// byte that stopped them, or `size` if none did.
+
+// Index of the first byte that is not a ' ', '\t' or '\r'
+size_t simd_skip_whitespace(const char *data, size_t size);
+// Index of the first '\n'
+size_t simd_find_newline(const char *data, size_t size);
+// Index of the first '"', '\\' or '\n' (the only bytes that matter inside a string literal)
+size_t simd_find_string_special(const char *data, size_t size);
+// How many '\n' there are
+size_t simd_count_newlines(const char *data, size_t size);
+
+// Sum of the items, wrapping around on overflow
+long simd_sum_integers(const long *data, size_t length);
+// Sum of the items, added in 4 interleaved lanes (by every implementation, so they all give the same
+// result, which may differ in the last bits from adding them one by one)
+double simd_sum_floats(const double *data, size_t length);
+
+// The name of the implementation selected at runtime ("avx2", "sse2" or "scalar")
+const char *simd_implementation_name(void);
+// Force one of the implementations by name. Returns false if it's not available on this cpu.
+// It is not thread safe, so only call it before starting to lex (the benchmarks use it to compare them).
+bool simd_use_implementation(const char *name);
+
+#endif // !SIMD_H_
@@ -0,0 +1,244 @@
+#include "./stream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "./loc.h"
+
+#define STREAM_READ_SIZE (64 * 1024)
+
+Stream stream_open(const char *filename) {
+    bool is_stdin = strcmp(filename, "-") == 0;
+    int fd = is_stdin ? STDIN_FILENO : open(filename, O_RDONLY);
+
+    if (fd < 0) {
+        fprintf(stderr, "could not open file %s due to: %s\n", filename, strerror(errno));
+        exit(1);
+    }
+
+    Stream stream = {
+        .fd = fd,
+        .filename = filename,
+        .lexer = create_stream_lexer(is_stdin ? "<stdin>" : filename),
+    };
+
+    return stream;
+}
+
+// The tokens point into `data`, so they go wherever it goes
+static void move_data(Stream *stream, char *data) {
+    for (size_t i = 0; i < stream->lexer.tokens.length; ++i) {
+        Token *token = &stream->lexer.tokens.data[i];
+
+        token->content = data + (token->content - stream->data);
+    }
+
+    stream->data = data;
+    stream->lexer.content = data;
+}
+
+// Drop the batch that was handed out, with its part of the content
+static void release_batch(Stream *stream) {
+    if (stream->batch_tokens == 0) return;
+
+    Tokens *tokens = &stream->lexer.tokens;
+    size_t size = stream->batch_size;
+
+    tokens->length -= stream->batch_tokens;
+    memmove(tokens->data, tokens->data + stream->batch_tokens, tokens->length * sizeof(Token));
+
+    for (size_t i = 0; i < tokens->length; ++i) tokens->data[i].content -= size;
+
+    stream->length -= size;
+    memmove(stream->data, stream->data + size, stream->length + 1); // with the '\0'
+
+    stream->lexer.base += size;
+    stream->lexer.cursor -= size;
+    stream->lexer.content_size -= size;
+    stream->scanned -= stream->batch_tokens;
+
+    stream->batch_tokens = 0;
+    stream->batch_size = 0;
+}
+
+// Read the next piece and lex its whole lines
+static void read_more(Stream *stream) {
+    // one more for the '\0'
+    if (stream->capacity - stream->length < STREAM_READ_SIZE + 1) {
+        size_t capacity = stream->capacity == 0 ? 2 * STREAM_READ_SIZE : 2 * stream->capacity;
+        char *data = realloc(stream->data, capacity);
+
+        if (data == NULL) {
+            fprintf(stderr, "could not allocate enough memory: %s\n", strerror(errno));
+            exit(1);
+        }
+
+        stream->capacity = capacity;
+        move_data(stream, data);
+    }
+
+    ssize_t read_size;
+
+    do {
+        read_size = read(stream->fd, stream->data + stream->length, STREAM_READ_SIZE);
+    } while (read_size < 0 && errno == EINTR);
+
+    if (read_size < 0) {
+        fprintf(stderr, "could not read file %s due to: %s\n", stream->filename, strerror(errno));
+        exit(1);
+    }
+
+    loc_stream_chunk(stream->lexer.file, stream->data + stream->length, read_size);
+
+    stream->length += read_size;
+    stream->data[stream->length] = '\0';
+    stream->end = read_size == 0;
+
+    size_t limit = stream->length;
+
+    if (!stream->end) {
+        while (limit > stream->lexer.cursor && stream->data[limit - 1] != '\n') --limit;
+
+        // not even one whole line yet
+        if (limit == stream->lexer.cursor) return;
+    }
+
+    stream->lexer.content_size = limit;
+    (void)lex(&stream->lexer);
+
+    // the lexer always ends with a TK_EOF, but this is not the end yet
+    if (!stream->end) --stream->lexer.tokens.length;
+}
+
+// The last '\n' outside of any brackets, or the TK_EOF at the end. It returns the number of tokens until
+// there (0 when there is none yet).
+static size_t find_cut(Stream *stream) {
+    Tokens *tokens = &stream->lexer.tokens;
+    size_t cut = 0;
+
+    for (; stream->scanned < tokens->length; ++stream->scanned) {
+        switch (tokens->data[stream->scanned].kind) {
+            case TK_LSQUARE: case TK_LBRACE: case TK_LPAREN: ++stream->depth; break;
+            case TK_RSQUARE: case TK_RBRACE: case TK_RPAREN: --stream->depth; break;
+            case TK_NEWLINE: if (stream->depth == 0) cut = stream->scanned + 1; break;
+            case TK_EOF: cut = stream->scanned + 1; break;
+            default: break;
+        }
+    }
+
+    return cut;
+}
+
+Token *stream_next(Stream *stream) {
+    release_batch(stream);
+
+    while (!stream->done) {
+        size_t cut = find_cut(stream);
+
+        if (cut == 0) {
+            read_more(stream);
+            continue;
+        }
+
+        Token *last = &stream->lexer.tokens.data[cut - 1];
+
+        stream->done = last->kind == TK_EOF;
+        stream->batch_tokens = cut;
+        stream->batch_size = stream->done ? stream->length : (size_t)(last->content + last->content_size - stream->data);
+        stream->batch_start = stream->lexer.base;
+
+        loc_stream_piece(stream->lexer.file, stream->batch_size);
+
+        // the errors were already shown, nothing of the file is parsed (as with the whole file)
+        if (stream->lexer.errors > 0) {
+            stream_forget_batch(stream);
+            release_batch(stream);
+            continue;
+        }
+
+        // the batch ends at the '\n', so it looks like the end of the file to the parser
+        last->kind = TK_EOF;
+
+        return stream->lexer.tokens.data;
+    }
+
+    return NULL;
+}
+
+void stream_forget_batch(Stream *stream) {
+    loc_stream_forget_piece(stream->lexer.file, stream->batch_start);
+}
+
+void stream_close(Stream *stream) {
+    if (stream->fd != STDIN_FILENO) close(stream->fd);
+
+    lexer_free(&stream->lexer);
+    free(stream->data);
+
+    *stream = (Stream){0};
+}
+
+Parser parse_stream(Stream *stream) {
+    Parser parser = {0};
+    Token *batch;
+
+    while ((batch = stream_next(stream))) {
+        parse_tokens_batch(&parser, batch);
+    }
+
+    parse_tokens_finish(&parser);
+
+    if (stream->lexer.errors > 0) {
+        parser_free(parser);
+
+        return (Parser){0};
+    }
+
+    return parser;
+}
+
+Map *stream_referenced_names(const char *filename, Arena *arena) {
+    struct stat info;
+
+    if (strcmp(filename, "-") == 0 || stat(filename, &info) < 0 || !S_ISREG(info.st_mode)) return NULL;
+
+    Stream stream = stream_open(filename);
+    Map *names = map_new(sizeof(bool));
+    bool known = true, referenced = true;
+    Token *batch;
+
+    while (known && (batch = stream_next(&stream))) {
+        for (Token *token = batch; token->kind != TK_EOF; ++token) {
+            if (token->kind != TK_PATH_ROOT || token[1].kind != TK_PATH_CHUNK) continue;
+
+            char *name = token[1].content;
+            size_t size = token[1].content_size;
+
+            if (name[0] == '"') {
+                name++;
+                size -= 2;
+
+                // it would have to be decoded like the parser does, it's easier to keep everything
+                if (memchr(name, '\\', size) != NULL) known = false;
+            }
+
+            if (map_get(names, name, size) == NULL) map_set(names, arena_strndup(arena, name, size), size, &referenced);
+        }
+    }
+
+    if (stream.lexer.errors > 0) exit(1);
+
+    stream_close(&stream);
+
+    if (!known) {
+        map_free(names);
+
+        return NULL;
+    }
+
+    return names;
+}
@@ -0,0 +1,58 @@
+#ifndef STREAM_H_
+#define STREAM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "./lexer.h"
+#include "./parser.h"
+#include "./arena.h"
+#include "./map.h"
+
+// A file read a piece at a time, for the ones that can't be mapped (pipes, `-` for the standard input) and
+// that we don't want to have whole in memory. Only the text and the tokens of the top-level vars that were
+// not handed out yet are kept, so the memory it takes is about the size of a read plus the biggest var.
+//
+// The lexer only runs up to the last '\n' that was read: no token goes past the end of a line (strings and
+// comments can't have one inside), so whatever was read after it (half a string or a number) is lexed
+// once the rest of its line comes. The tokens are then cut at the last '\n' outside of any brackets,
+// which always ends a top-level var.
+typedef struct {
+    int fd;
+    const char *filename;
+    Lexer lexer;
+
+    // What was read and not released yet, it starts at `lexer.base` in the file
+    char *data;
+    size_t length, capacity;
+    // nothing else to read
+    bool end;
+
+    // The brackets opened by the first `scanned` tokens and still open after them
+    long depth;
+    size_t scanned;
+
+    // The batch handed out by the last `stream_next`, released by the next one
+    size_t batch_tokens, batch_size, batch_start;
+    bool done;
+} Stream;
+
+// "-" is the standard input. It exits when the file can't be opened.
+Stream stream_open(const char *filename);
+// The tokens of the next whole top-level vars, ending with a TK_EOF (see `parse_tokens_batch`). They, and
+// the content they point to, are valid until the next call. NULL at the end or when the lexer found errors.
+Token *stream_next(Stream *stream);
+// The locations in the batch handed out by the last `stream_next` won't be shown anymore (what was parsed from
+// it was released), so where its lines start is forgotten too. Otherwise they are kept until `stream_close`.
+void stream_forget_batch(Stream *stream);
+void stream_close(Stream *stream);
+
+// All of the batches parsed into a single parser, which is empty when the lexer found errors (as `parse_tokens`)
+Parser parse_stream(Stream *stream);
+
+// The names the paths of the file start with (`a` for `$/a/b`), from a first pass that only lexes it, so the
+// vars nobody references are known before they are read (see `evalset --stream`). The names are copied to `arena`.
+// NULL when they can't be known: the file can't be read twice (the standard input, pipes) or one of them
+// has an escape sequence. It exits when the lexer finds errors (they were shown already).
+Map *stream_referenced_names(const char *filename, Arena *arena);
+
+#endif // STREAM_H_
@@ -6,3 +6,40 @@ bool cmp_sized_strings(const char *a, size_t as, const char *b, size_t bs) {
 
     return strncmp(a, b, as) == 0;
 }
+
+void string_builder_reserve(String_Builder *builder, size_t size) {
+    if (builder->data != NULL && builder->capacity >= size) return;
+
+    // + 1 for the null terminator
+    char *output = builder->arena != NULL
+        ? arena_realloc(builder->arena, builder->data, builder->data == NULL ? 0 : builder->capacity + 1, size + 1)
+        : realloc(builder->data, size + 1);
+    assert(output != NULL && "failed to reallocate string");
+
+    if (builder->data == NULL) output[0] = '\0';
+
+    builder->data = output;
+    builder->capacity = size;
+}
+
+void string_builder_append(String_Builder *builder, const char *string, size_t size) {
+    // the empty pieces may have no data at all
+    if (size == 0) {
+        if (builder->data == NULL) string_builder_reserve(builder, 0);
+
+        return;
+    }
+
+    if (builder->length + size > builder->capacity) {
+        size_t capacity = builder->capacity * 2;
+
+        if (capacity < builder->length + size) capacity = builder->length + size;
+
+        string_builder_reserve(builder, capacity);
+    }
+
+    memcpy(builder->data + builder->length, string, size);
+
+    builder->length += size;
+    builder->data[builder->length] = '\0';
+}
@@ -2,7 +2,59 @@
 #define UTILS_H_
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "./arena.h"
+
+// Most of the arrays are small (a couple of function arguments, a single index...), so we start small
+// and double the capacity every time it's not enough.
+#define DEFAULT_ARRAY_CAPACITY 4
+
+#define array_append(array, item) do { \
+    if ((array)->length >= (array)->capacity) { \
+        if ((array)->capacity == 0) (array)->capacity = DEFAULT_ARRAY_CAPACITY; \
+        else (array)->capacity = (array)->capacity * 2; \
+        void *output = realloc((array)->data, (array)->capacity * sizeof((array)->data[0])); \
+        assert(output != NULL && "failed to reallocate array"); \
+        (array)->data = output; \
+    } \
+    (array)->data[(array)->length++] = item; \
+} while (0);
+
+#define array_free(array) do { \
+    free((array)->data); \
+    (array)->data = NULL; \
+    (array)->capacity = 0; \
+    (array)->length = 0; \
+} while (0);
+
+#define array_flush(array) (array)->length = 0;
+
+// Grow the array to hold at least `count` items without touching its length.
+// Useful when we already know (or can guess) how many items are coming.
+#define array_reserve(array, count) do { \
+    if ((array)->capacity < (count)) { \
+        (array)->capacity = (count); \
+        void *output = realloc((array)->data, (array)->capacity * sizeof((array)->data[0])); \
+        assert(output != NULL && "failed to reallocate array"); \
+        (array)->data = output; \
+    } \
+} while (0);
 
 bool cmp_sized_strings(const char *a, size_t as, const char *b, size_t bs);
 
+// Builds a string out of pieces with a single allocation: reserve the total size first (add up the
+// sizes of the pieces), then append them. It grows if it's not enough, so guessing is fine too.
+// The data is always null-terminated (even when nothing was appended), the terminator is not counted in the length.
+typedef struct {
+    size_t length, capacity;
+    char *data;
+
+    // when it's set the data comes from it, and it's released with it instead of with free()
+    Arena *arena;
+} String_Builder;
+
+void string_builder_reserve(String_Builder *builder, size_t size);
+void string_builder_append(String_Builder *builder, const char *string, size_t size);
+
 #endif // !UTILS_H_